@@ -3,5 +3,41 @@
 #include "BerlinByTest.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, BerlinByTest, "BerlinByTest" );
+DEFINE_STAT(STAT_AutoAimCandidates);
+DEFINE_STAT(STAT_AutoAimTraces);
+DEFINE_STAT(STAT_ProjectileActors);
+DEFINE_STAT(STAT_PooledProjectilesInFlight);
+DEFINE_STAT(STAT_SimulatedProjectiles);
+
+CSV_DEFINE_CATEGORY_MODULE(BERLINBYTEST_API, BerlinByTest, true);
+
+// Stats of the memory tags of the game, both in the full list and in the summary of "stat LLM"
+DECLARE_LLM_MEMORY_STAT(TEXT("Projectiles"), STAT_ProjectilesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Shootables"), STAT_ShootablesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("AI"), STAT_AILLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("HUD"), STAT_HUDLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("BerlinByTest"), STAT_BerlinByTestSummaryLLM, STATGROUP_LLM);
+#if STATS
+#define BERLINBYTEST_LLM_STAT_FNAME(Stat) GET_STATFNAME(Stat)
+#else
+#define BERLINBYTEST_LLM_STAT_FNAME(Stat) NAME_None
+#endif
+
+// Game module, which registers the memory tags of the game before any of them is used
+class FBerlinByTestModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		FLowLevelMemTracker& MemTracker = FLowLevelMemTracker::Get();
+		MemTracker.RegisterProjectTag(static_cast<int32>(EBerlinByTestLLMTag::Projectiles), TEXT("Projectiles"), BERLINBYTEST_LLM_STAT_FNAME(STAT_ProjectilesLLM), BERLINBYTEST_LLM_STAT_FNAME(STAT_BerlinByTestSummaryLLM));
+		MemTracker.RegisterProjectTag(static_cast<int32>(EBerlinByTestLLMTag::Shootables), TEXT("Shootables"), BERLINBYTEST_LLM_STAT_FNAME(STAT_ShootablesLLM), BERLINBYTEST_LLM_STAT_FNAME(STAT_BerlinByTestSummaryLLM));
+		MemTracker.RegisterProjectTag(static_cast<int32>(EBerlinByTestLLMTag::AI), TEXT("AI"), BERLINBYTEST_LLM_STAT_FNAME(STAT_AILLM), BERLINBYTEST_LLM_STAT_FNAME(STAT_BerlinByTestSummaryLLM));
+		MemTracker.RegisterProjectTag(static_cast<int32>(EBerlinByTestLLMTag::HUD), TEXT("HUD"), BERLINBYTEST_LLM_STAT_FNAME(STAT_HUDLLM), BERLINBYTEST_LLM_STAT_FNAME(STAT_BerlinByTestSummaryLLM));
+#endif
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FBerlinByTestModule, BerlinByTest, "BerlinByTest" );
  
\ No newline at end of file
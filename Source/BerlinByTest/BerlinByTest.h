@@ -3,3 +3,32 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Groups every stat of the game, so that they can be shown with "stat BerlinByTest"
+DECLARE_STATS_GROUP(TEXT("BerlinByTest"), STATGROUP_BerlinByTest, STATCAT_Advanced);
+
+// Counters shared by several systems of the game
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Auto-Aim Candidates"), STAT_AutoAimCandidates, STATGROUP_BerlinByTest, BERLINBYTEST_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Auto-Aim Traces"), STAT_AutoAimTraces, STATGROUP_BerlinByTest, BERLINBYTEST_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Projectile Actors"), STAT_ProjectileActors, STATGROUP_BerlinByTest, BERLINBYTEST_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pooled Projectiles In Flight"), STAT_PooledProjectilesInFlight, STATGROUP_BerlinByTest, BERLINBYTEST_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Simulated Projectiles"), STAT_SimulatedProjectiles, STATGROUP_BerlinByTest, BERLINBYTEST_API);
+
+// Category of the game in CSV profiler captures, e.g. the ones taken with "csvprofile start" on headless servers
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BERLINBYTEST_API, BerlinByTest);
+
+/** Tags of the memory of the game in Low Level Memory Tracker captures, e.g. the ones taken with -llm or shown with "stat LLMFULL".
+	They are registered by the game module, and applied with BERLINBYTEST_LLM_SCOPE in the entry points of every system */
+enum class EBerlinByTestLLMTag : LLM_TAG_TYPE
+{
+	Projectiles = static_cast<LLM_TAG_TYPE>(ELLMTag::ProjectTagStart),
+	Shootables,
+	AI,
+	HUD
+};
+
+// Tags every allocation done until the end of the scope with one of the tags of the game
+#define BERLINBYTEST_LLM_SCOPE(Tag) LLM_SCOPE(static_cast<ELLMTag>(EBerlinByTestLLMTag::Tag))
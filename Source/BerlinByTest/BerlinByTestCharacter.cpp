@@ -2,6 +2,7 @@
 
 #include "BerlinByTestCharacter.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
+#include "BerlinByTestCharacterMovementComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
@@ -10,11 +11,13 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "Public/Projectiles/ProjectileShooterComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "AI/AISignificanceManager.h"
 
 //////////////////////////////////////////////////////////////////////////
 // ABerlinByTestCharacter
 
-ABerlinByTestCharacter::ABerlinByTestCharacter()
+ABerlinByTestCharacter::ABerlinByTestCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UBerlinByTestCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -64,6 +67,13 @@ ABerlinByTestCharacter::ABerlinByTestCharacter()
 	}
 }
 
+void ABerlinByTestCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+	// The AI lower their update rate depending on how far they are from the players, so there must be a significance manager
+	AAISignificanceManager::Get(this);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -71,8 +81,8 @@ void ABerlinByTestCharacter::SetupPlayerInputComponent(class UInputComponent* Pl
 {
 	// Set up gameplay key bindings
 	check(PlayerInputComponent);
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
+	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ABerlinByTestCharacter::JumpPressed);
+	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ABerlinByTestCharacter::JumpReleased);
 
 	PlayerInputComponent->BindAxis("MoveForward", this, &ABerlinByTestCharacter::MoveForward);
 	PlayerInputComponent->BindAxis("MoveRight", this, &ABerlinByTestCharacter::MoveRight);
@@ -80,9 +90,9 @@ void ABerlinByTestCharacter::SetupPlayerInputComponent(class UInputComponent* Pl
 	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
 	// "turn" handles devices that provide an absolute delta, such as a mouse.
 	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
-	PlayerInputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
+	PlayerInputComponent->BindAxis("Turn", this, &ABerlinByTestCharacter::Turn);
 	PlayerInputComponent->BindAxis("TurnRate", this, &ABerlinByTestCharacter::TurnAtRate);
-	PlayerInputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
+	PlayerInputComponent->BindAxis("LookUp", this, &ABerlinByTestCharacter::LookUp);
 	PlayerInputComponent->BindAxis("LookUpRate", this, &ABerlinByTestCharacter::LookUpAtRate);
 
 	// handle touch devices
@@ -104,28 +114,53 @@ void ABerlinByTestCharacter::OnResetVR()
 
 void ABerlinByTestCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Location)
 {
-		Jump();
+		JumpPressed();
 }
 
 void ABerlinByTestCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector Location)
 {
-		StopJumping();
+		JumpReleased();
+}
+
+void ABerlinByTestCharacter::JumpPressed()
+{
+	InputFrame.bJumpPressed = true;
+	Jump();
+}
+
+void ABerlinByTestCharacter::JumpReleased()
+{
+	InputFrame.bJumpReleased = true;
+	StopJumping();
+}
+
+void ABerlinByTestCharacter::Turn(float Value)
+{
+	InputFrame.Turn += Value;
+	AddControllerYawInput(Value);
+}
+
+void ABerlinByTestCharacter::LookUp(float Value)
+{
+	InputFrame.LookUp += Value;
+	AddControllerPitchInput(Value);
 }
 
 void ABerlinByTestCharacter::TurnAtRate(float Rate)
 {
 	// calculate delta for this frame from the rate information
-	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
+	Turn(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
 }
 
 void ABerlinByTestCharacter::LookUpAtRate(float Rate)
 {
 	// calculate delta for this frame from the rate information
-	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
+	LookUp(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
 }
 
 void ABerlinByTestCharacter::MoveForward(float Value)
 {
+	InputFrame.MoveForward = Value;
 	if ((Controller != NULL) && (Value != 0.0f))
 	{
 		// find out which way is forward
@@ -140,6 +175,7 @@ void ABerlinByTestCharacter::MoveForward(float Value)
 
 void ABerlinByTestCharacter::MoveRight(float Value)
 {
+	InputFrame.MoveRight = Value;
 	if ( (Controller != NULL) && (Value != 0.0f) )
 	{
 		// find out which way is right
@@ -155,8 +191,37 @@ void ABerlinByTestCharacter::MoveRight(float Value)
 
 void ABerlinByTestCharacter::Shoot()
 {
+	++InputFrame.NumShots;
 	if (ProjectileShooterComponent->IsValidLowLevel())
 	{
 		ProjectileShooterComponent->Shoot();
 	}
 }
+
+FCharacterInputFrame ABerlinByTestCharacter::ConsumeInputFrame()
+{
+	const FCharacterInputFrame ConsumedInputFrame = InputFrame;
+	InputFrame = FCharacterInputFrame();
+	return ConsumedInputFrame;
+}
+
+void ABerlinByTestCharacter::ApplyInputFrame(const FCharacterInputFrame& InInputFrame)
+{
+	// The input goes through the same functions as the live input, in the order in which it is bound
+	if (InInputFrame.bJumpPressed)
+	{
+		JumpPressed();
+	}
+	if (InInputFrame.bJumpReleased)
+	{
+		JumpReleased();
+	}
+	MoveForward(InInputFrame.MoveForward);
+	MoveRight(InInputFrame.MoveRight);
+	Turn(InInputFrame.Turn);
+	LookUp(InInputFrame.LookUp);
+	for (int32 ShotIndex = 0; ShotIndex < InInputFrame.NumShots; ++ShotIndex)
+	{
+		Shoot();
+	}
+}
@@ -8,6 +8,30 @@
 
 class UProjectileShooterComponent;
 
+// Input given to a player character during a single frame, which is what play sessions record and replay
+struct FCharacterInputFrame
+{
+	float MoveForward;
+	float MoveRight;
+	// Yaw and pitch input added to the controller, including the one coming from turn and look up rates
+	float Turn;
+	float LookUp;
+	bool bJumpPressed;
+	bool bJumpReleased;
+	uint8 NumShots;
+
+	FCharacterInputFrame()
+		: MoveForward(0.f)
+		, MoveRight(0.f)
+		, Turn(0.f)
+		, LookUp(0.f)
+		, bJumpPressed(false)
+		, bJumpReleased(false)
+		, NumShots(0)
+	{
+	}
+};
+
 UCLASS(config=Game)
 class ABerlinByTestCharacter : public ACharacter
 {
@@ -21,7 +45,8 @@ class ABerlinByTestCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
 public:
-	ABerlinByTestCharacter();
+	// Sets default values, replacing the character movement component with the one of the game
+	ABerlinByTestCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -42,6 +67,18 @@ protected:
 	/** Called for side to side input */
 	void MoveRight(float Value);
 
+	/** Called for yaw input, e.g. from a mouse */
+	void Turn(float Value);
+
+	/** Called for pitch input, e.g. from a mouse */
+	void LookUp(float Value);
+
+	/** Called when the jump input is pressed */
+	void JumpPressed();
+
+	/** Called when the jump input is released */
+	void JumpReleased();
+
 	// Called to shoot projectiles
 	void Shoot();
 
@@ -68,14 +105,26 @@ protected:
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	// End of APawn interface
 
+	// AActor interface
+	virtual void BeginPlay() override;
+	// End of AActor interface
+
 public:
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns ProjectileShooterComponent subobject **/
+	FORCEINLINE UProjectileShooterComponent* GetProjectileShooterComponent() const { return ProjectileShooterComponent; }
+	// Returns the input given to the character since the last call, and starts gathering the input of the next frame
+	FCharacterInputFrame ConsumeInputFrame();
+	// Gives the character the same input as it was given in a recorded frame
+	void ApplyInputFrame(const FCharacterInputFrame& InInputFrame);
 private:
 	// Component used to shoot projectiles
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 		UProjectileShooterComponent* ProjectileShooterComponent;
+	// Input given to the character during the current frame
+	FCharacterInputFrame InputFrame;
 };
 
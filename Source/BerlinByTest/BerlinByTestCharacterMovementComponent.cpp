@@ -0,0 +1,296 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BerlinByTestCharacterMovementComponent.h"
+#include "BerlinByTest.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/CoreNet.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Quantized Server Moves"), STAT_QuantizedServerMoves, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Full Server Moves"), STAT_FullServerMoves, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Quantized Server Move Bits"), STAT_QuantizedServerMoveBits, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Checked Client Moves"), STAT_CheckedClientMoves, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Corrections"), STAT_MovementCorrections, STATGROUP_BerlinByTest);
+
+DEFINE_LOG_CATEGORY_STATIC(LogBerlinByTestMovement, Log, All);
+
+static TAutoConsoleVariable<float> CVarMovementReportInterval(
+	TEXT("BerlinByTest.Movement.ReportInterval"),
+	0.f,
+	TEXT("Seconds between the logs of the moves sent by every owning client and the moves checked and corrected by the server.\n")
+	TEXT("0: Off"),
+	ECVF_Default);
+
+// Bits used by each part of a quantized move
+static const int32 NumAccelerationDirectionBits = 10;
+static const int32 NumAccelerationMagnitudeBits = 4;
+static const int32 NumViewYawBits = 12;
+static const int32 NumViewPitchBits = 10;
+
+FQuantizedCharacterMove::FQuantizedCharacterMove()
+	: TimeStamp(0.f)
+	, QuantizedAcceleration(0)
+	, ClientLocation(FVector::ZeroVector)
+	, CompressedMoveFlags(0)
+	, QuantizedView(0)
+	, ClientMovementMode(0)
+{
+}
+
+bool FQuantizedCharacterMove::QuantizeAcceleration(const FVector& InAcceleration, float InMaximumAcceleration, uint16& OutQuantizedAcceleration)
+{
+	OutQuantizedAcceleration = 0;
+	const bool bCanQuantize = FMath::IsNearlyZero(InAcceleration.Z) && (InMaximumAcceleration > 0.f);
+	if (bCanQuantize)
+	{
+		const int32 MaximumMagnitude = (1 << NumAccelerationMagnitudeBits) - 1;
+		const int32 Magnitude = FMath::Clamp(FMath::RoundToInt(InAcceleration.Size2D() * MaximumMagnitude / InMaximumAcceleration), 0, MaximumMagnitude);
+		// Without magnitude there is no direction, so that every zero acceleration is quantized the same way
+		if (Magnitude > 0)
+		{
+			const float Yaw = FMath::RadiansToDegrees(FMath::Atan2(InAcceleration.Y, InAcceleration.X));
+			const int32 Direction = FMath::RoundToInt(Yaw * (1 << NumAccelerationDirectionBits) / 360.f) & ((1 << NumAccelerationDirectionBits) - 1);
+			OutQuantizedAcceleration = static_cast<uint16>((Magnitude << NumAccelerationDirectionBits) | Direction);
+		}
+	}
+	return bCanQuantize;
+}
+
+FVector FQuantizedCharacterMove::DequantizeAcceleration(uint16 InQuantizedAcceleration, float InMaximumAcceleration)
+{
+	const int32 MaximumMagnitude = (1 << NumAccelerationMagnitudeBits) - 1;
+	const int32 Magnitude = InQuantizedAcceleration >> NumAccelerationDirectionBits;
+	const int32 Direction = InQuantizedAcceleration & ((1 << NumAccelerationDirectionBits) - 1);
+	float DirectionSine;
+	float DirectionCosine;
+	FMath::SinCos(&DirectionSine, &DirectionCosine, FMath::DegreesToRadians(Direction * 360.f / (1 << NumAccelerationDirectionBits)));
+	return FVector(DirectionCosine, DirectionSine, 0.f) * (InMaximumAcceleration * Magnitude / MaximumMagnitude);
+}
+
+uint32 FQuantizedCharacterMove::QuantizeView(const FRotator& InControlRotation)
+{
+	// The most significant bits of the compressed axes are kept, which is the same as rounding them down to fewer steps
+	const uint32 Yaw = FRotator::CompressAxisToShort(InControlRotation.Yaw) >> (16 - NumViewYawBits);
+	const uint32 Pitch = FRotator::CompressAxisToShort(InControlRotation.Pitch) >> (16 - NumViewPitchBits);
+	return (Yaw << NumViewPitchBits) | Pitch;
+}
+
+uint32 FQuantizedCharacterMove::DequantizeView(uint32 InQuantizedView)
+{
+	const uint32 YawShort = (InQuantizedView >> NumViewPitchBits) << (16 - NumViewYawBits);
+	const uint32 PitchShort = (InQuantizedView & ((1 << NumViewPitchBits) - 1)) << (16 - NumViewPitchBits);
+	return (YawShort << 16) | PitchShort;
+}
+
+bool FQuantizedCharacterMove::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// The time stamp is sent whole, as the server compares it with the ones of the previous moves
+	Ar << TimeStamp;
+	uint32 Acceleration = QuantizedAcceleration;
+	Ar.SerializeBits(&Acceleration, NumAccelerationDirectionBits + NumAccelerationMagnitudeBits);
+	QuantizedAcceleration = static_cast<uint16>(Acceleration);
+	bool bLocationSuccess = true;
+	ClientLocation.NetSerialize(Ar, Map, bLocationSuccess);
+	Ar << CompressedMoveFlags;
+	Ar.SerializeBits(&QuantizedView, NumViewYawBits + NumViewPitchBits);
+	Ar << ClientMovementMode;
+	bOutSuccess = bLocationSuccess && !Ar.IsError();
+	return true;
+}
+
+void FSavedMove_BerlinByTest::Clear()
+{
+	Super::Clear();
+	bIsAccelerationQuantized = false;
+	QuantizedAcceleration = 0;
+}
+
+void FSavedMove_BerlinByTest::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+	// The client moves with the acceleration the server will receive, so that both of them simulate the same move
+	const UCharacterMovementComponent* const MovementComponent = C->GetCharacterMovement();
+	bIsAccelerationQuantized = FQuantizedCharacterMove::QuantizeAcceleration(Acceleration, MovementComponent->GetMaxAcceleration(), QuantizedAcceleration);
+	if (bIsAccelerationQuantized)
+	{
+		Acceleration = FQuantizedCharacterMove::DequantizeAcceleration(QuantizedAcceleration, MovementComponent->GetMaxAcceleration());
+	}
+}
+
+bool FSavedMove_BerlinByTest::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_BerlinByTest* const NewQuantizedMove = static_cast<const FSavedMove_BerlinByTest*>(NewMove.Get());
+	bool bCanCombine = (bIsAccelerationQuantized == NewQuantizedMove->bIsAccelerationQuantized);
+	// Comparing the quantized accelerations is enough to know that the input is the same
+	if (bCanCombine && bIsAccelerationQuantized)
+	{
+		bCanCombine = (QuantizedAcceleration == NewQuantizedMove->QuantizedAcceleration);
+	}
+	return bCanCombine && Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+FNetworkPredictionData_Client_BerlinByTest::FNetworkPredictionData_Client_BerlinByTest(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_BerlinByTest::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_BerlinByTest());
+}
+
+// Sets default values for this component's properties
+UBerlinByTestCharacterMovementComponent::UBerlinByTestCharacterMovementComponent()
+{
+	bUseAdaptiveNetSendRate = true;
+	SteadyInputNetSendDeltaTime = 0.05f;
+	LastSentQuantizedAcceleration = 0;
+	LastSentCompressedMoveFlags = 0;
+	bHasSentQuantizedMove = false;
+	NumReportedSentMoves = 0;
+	NumReportedSentBits = 0;
+	NumReportedReceivedMoves = 0;
+	NumReportedCorrections = 0;
+	ReportElapsedTimeInSeconds = 0.f;
+}
+
+FNetworkPredictionData_Client* UBerlinByTestCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UBerlinByTestCharacterMovementComponent* const MutableThis = const_cast<UBerlinByTestCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_BerlinByTest(*this);
+	}
+	return ClientPredictionData;
+}
+
+void UBerlinByTestCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	UpdateMovementReport(DeltaTime);
+}
+
+bool UBerlinByTestCharacterMovementComponent::CanSendQuantizedMove(const FSavedMove_Character* InMove) const
+{
+	// Moves on movable bases are sent relative to them, which needs the base to be sent as well
+	const FSavedMove_BerlinByTest* const QuantizedMove = static_cast<const FSavedMove_BerlinByTest*>(InMove);
+	return QuantizedMove->bIsAccelerationQuantized && !MovementBaseUtility::UseRelativeLocation(InMove->EndBase.Get());
+}
+
+void UBerlinByTestCharacterMovementComponent::CallServerMove(const FSavedMove_Character* NewMove, const FSavedMove_Character* OldMove)
+{
+	const FNetworkPredictionData_Client_Character* const ClientData = GetPredictionData_Client_Character();
+	// Old and pending moves are sent along with the new one by the character movement component
+	if ((OldMove == nullptr) && !ClientData->PendingMove.IsValid() && CanSendQuantizedMove(NewMove))
+	{
+		FQuantizedCharacterMove Move;
+		Move.TimeStamp = NewMove->TimeStamp;
+		Move.QuantizedAcceleration = static_cast<const FSavedMove_BerlinByTest*>(NewMove)->QuantizedAcceleration;
+		Move.ClientLocation = NewMove->SavedLocation;
+		Move.CompressedMoveFlags = NewMove->GetCompressedFlags();
+		Move.QuantizedView = FQuantizedCharacterMove::QuantizeView(NewMove->SavedControlRotation);
+		Move.ClientMovementMode = NewMove->EndPackedMovementMode;
+		ServerMoveQuantized(Move);
+		MarkForClientCameraUpdate();
+		LastSentQuantizedAcceleration = Move.QuantizedAcceleration;
+		LastSentCompressedMoveFlags = Move.CompressedMoveFlags;
+		bHasSentQuantizedMove = true;
+		int32 NumMoveBits = 0;
+#if STATS || CSV_PROFILER
+		// The move is written once more to measure it, which is only worth it while profiling
+		FNetBitWriter MoveWriter(nullptr, 256);
+		bool bHasMeasured;
+		Move.NetSerialize(MoveWriter, nullptr, bHasMeasured);
+		NumMoveBits = static_cast<int32>(MoveWriter.GetNumBits());
+#endif
+		INC_DWORD_STAT(STAT_QuantizedServerMoves);
+		INC_DWORD_STAT_BY(STAT_QuantizedServerMoveBits, NumMoveBits);
+		CSV_CUSTOM_STAT(BerlinByTest, QuantizedServerMoves, 1, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(BerlinByTest, QuantizedServerMoveBits, NumMoveBits, ECsvCustomStatOp::Accumulate);
+		CountSentMove(NumMoveBits);
+	}
+	else
+	{
+		Super::CallServerMove(NewMove, OldMove);
+		bHasSentQuantizedMove = false;
+		INC_DWORD_STAT(STAT_FullServerMoves);
+		CSV_CUSTOM_STAT(BerlinByTest, FullServerMoves, 1, ECsvCustomStatOp::Accumulate);
+		CountSentMove(0);
+	}
+}
+
+bool UBerlinByTestCharacterMovementComponent::ServerMoveQuantized_Validate(const FQuantizedCharacterMove& InMove)
+{
+	return !InMove.ClientLocation.ContainsNaN();
+}
+
+void UBerlinByTestCharacterMovementComponent::ServerMoveQuantized_Implementation(const FQuantizedCharacterMove& InMove)
+{
+	// The server moves with the same acceleration the client did, and with the base the client moved on when it is not movable
+	const FVector Acceleration = FQuantizedCharacterMove::DequantizeAcceleration(InMove.QuantizedAcceleration, GetMaxAcceleration());
+	ServerMove_Implementation(InMove.TimeStamp, Acceleration, InMove.ClientLocation, InMove.CompressedMoveFlags, 0, FQuantizedCharacterMove::DequantizeView(InMove.QuantizedView), nullptr, NAME_None, InMove.ClientMovementMode);
+}
+
+float UBerlinByTestCharacterMovementComponent::GetClientNetSendDeltaTime(const APlayerController* PC, const FNetworkPredictionData_Client_Character* ClientData, const FSavedMovePtr& NewMove) const
+{
+	float NetSendDeltaTime = Super::GetClientNetSendDeltaTime(PC, ClientData, NewMove);
+	const FSavedMove_BerlinByTest* const QuantizedMove = static_cast<const FSavedMove_BerlinByTest*>(NewMove.Get());
+	// While the input doesn't change, the moves are combined for longer before sending them, which the server sees as a single longer move
+	if (bUseAdaptiveNetSendRate && bHasSentQuantizedMove && (QuantizedMove != nullptr) && QuantizedMove->bIsAccelerationQuantized)
+	{
+		const bool bIsInputSteady = (QuantizedMove->QuantizedAcceleration == LastSentQuantizedAcceleration) && (QuantizedMove->GetCompressedFlags() == LastSentCompressedMoveFlags);
+		if (bIsInputSteady)
+		{
+			NetSendDeltaTime = FMath::Max(NetSendDeltaTime, SteadyInputNetSendDeltaTime);
+		}
+	}
+	return NetSendDeltaTime;
+}
+
+bool UBerlinByTestCharacterMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	const bool bNeedsCorrection = Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientWorldLocation, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+	++NumReportedReceivedMoves;
+	INC_DWORD_STAT(STAT_CheckedClientMoves);
+	CSV_CUSTOM_STAT(BerlinByTest, CheckedClientMoves, 1, ECsvCustomStatOp::Accumulate);
+	if (bNeedsCorrection)
+	{
+		++NumReportedCorrections;
+		INC_DWORD_STAT(STAT_MovementCorrections);
+		CSV_CUSTOM_STAT(BerlinByTest, MovementCorrections, 1, ECsvCustomStatOp::Accumulate);
+	}
+	return bNeedsCorrection;
+}
+
+void UBerlinByTestCharacterMovementComponent::CountSentMove(int32 InNumBits)
+{
+	++NumReportedSentMoves;
+	NumReportedSentBits += InNumBits;
+}
+
+void UBerlinByTestCharacterMovementComponent::UpdateMovementReport(float InDeltaTime)
+{
+	const float ReportIntervalInSeconds = CVarMovementReportInterval.GetValueOnGameThread();
+	ReportElapsedTimeInSeconds += InDeltaTime;
+	if ((ReportIntervalInSeconds > 0.f) && (ReportElapsedTimeInSeconds >= ReportIntervalInSeconds))
+	{
+		const FString CharacterName = GetNameSafe(CharacterOwner);
+		if (NumReportedSentMoves > 0)
+		{
+			UE_LOG(LogBerlinByTestMovement, Display, TEXT("%s sent %.1f moves/s, with %.0f bits/s of quantized moves"), *CharacterName, NumReportedSentMoves / ReportElapsedTimeInSeconds, NumReportedSentBits / ReportElapsedTimeInSeconds);
+		}
+		if (NumReportedReceivedMoves > 0)
+		{
+			UE_LOG(LogBerlinByTestMovement, Display, TEXT("%s had %.1f moves/s checked by the server, %.2f/s corrected (%.1f%%)"), *CharacterName, NumReportedReceivedMoves / ReportElapsedTimeInSeconds, NumReportedCorrections / ReportElapsedTimeInSeconds, 100.f * NumReportedCorrections / NumReportedReceivedMoves);
+		}
+	}
+	// The counts are restarted even while the reports are disabled, so that the first report only covers its own interval
+	if ((ReportIntervalInSeconds <= 0.f) || (ReportElapsedTimeInSeconds >= ReportIntervalInSeconds))
+	{
+		NumReportedSentMoves = 0;
+		NumReportedSentBits = 0;
+		NumReportedReceivedMoves = 0;
+		NumReportedCorrections = 0;
+		ReportElapsedTimeInSeconds = 0.f;
+	}
+}
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/NetSerialization.h"
+#include "BerlinByTestCharacterMovementComponent.generated.h"
+
+/** Move sent by an owning client to the server when its acceleration can be quantized, with as few bits as possible.
+	The acceleration is sent as a 10 bit direction and a 4 bit magnitude, and the control rotation as a 12 bit yaw and a 10 bit
+	pitch, instead of the three quantized components of the acceleration and the 32 bits of the view of a regular move */
+USTRUCT()
+struct BERLINBYTEST_API FQuantizedCharacterMove
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		float TimeStamp;
+	UPROPERTY()
+		uint16 QuantizedAcceleration;
+	UPROPERTY()
+		FVector_NetQuantize100 ClientLocation;
+	UPROPERTY()
+		uint8 CompressedMoveFlags;
+	UPROPERTY()
+		uint32 QuantizedView;
+	UPROPERTY()
+		uint8 ClientMovementMode;
+
+	FQuantizedCharacterMove();
+	/** Quantizes a horizontal acceleration relative to the maximum acceleration.
+		Returns false if it has a vertical component, e.g. while flying or swimming, which can't be quantized */
+	static bool QuantizeAcceleration(const FVector& InAcceleration, float InMaximumAcceleration, uint16& OutQuantizedAcceleration);
+	// Returns the acceleration a quantized acceleration stands for
+	static FVector DequantizeAcceleration(uint16 InQuantizedAcceleration, float InMaximumAcceleration);
+	// Quantizes the yaw and pitch of a control rotation, discarding its roll
+	static uint32 QuantizeView(const FRotator& InControlRotation);
+	// Returns the yaw and pitch of a quantized control rotation, packed as the character movement component expects them
+	static uint32 DequantizeView(uint32 InQuantizedView);
+	// Writes or reads the move with as few bits as possible
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FQuantizedCharacterMove> : public TStructOpsTypeTraitsBase2<FQuantizedCharacterMove>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+// Saved move that quantizes its acceleration, so that the client simulates exactly the same move the server will receive
+class FSavedMove_BerlinByTest : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	// Clears the move so that it can be reused
+	virtual void Clear() override;
+	// Sets up the move, quantizing its acceleration if possible
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	/** Returns true if the new move can be combined with this one. As the acceleration is quantized, consecutive moves with
+		slightly different input end up with the same acceleration and are combined */
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	// Whether the acceleration of the move could be quantized, which lets it be sent as a quantized move
+	bool bIsAccelerationQuantized;
+	uint16 QuantizedAcceleration;
+};
+
+// Client prediction data that allocates the saved moves of the game
+class FNetworkPredictionData_Client_BerlinByTest : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_BerlinByTest(const UCharacterMovementComponent& ClientMovement);
+	// Allocates a saved move of the game
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+/** Character movement that spends less bandwidth replicating the moves of the owning client to the server:
+	the acceleration and control rotation are quantized, moves with the same quantized input are combined, and moves are sent
+	less often while the input doesn't change. The server still checks every move and corrects the client when they diverge.
+	The moves, bits and corrections of every character are counted in stats and CSV captures, and can be logged periodically
+	with BerlinByTest.Movement.ReportInterval */
+UCLASS()
+class BERLINBYTEST_API UBerlinByTestCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this component's properties
+	UBerlinByTestCharacterMovementComponent();
+	// Returns the client prediction data, creating it if needed
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	// Sends the move as a quantized move when possible, or as the moves of the character movement component otherwise
+	virtual void CallServerMove(const FSavedMove_Character* NewMove, const FSavedMove_Character* OldMove) override;
+	// Returns how long the client waits between moves, which is longer while the input doesn't change
+	virtual float GetClientNetSendDeltaTime(const APlayerController* PC, const FNetworkPredictionData_Client_Character* ClientData, const FSavedMovePtr& NewMove) const override;
+	// Counts the moves checked by the server, along with the ones that have to be corrected
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+private:
+	// Returns true if the move can be sent as a quantized move
+	bool CanSendQuantizedMove(const FSavedMove_Character* InMove) const;
+	// Moves the character on the server with a quantized move of the owning client
+	UFUNCTION(Server, Unreliable, WithValidation)
+		void ServerMoveQuantized(const FQuantizedCharacterMove& InMove);
+	// Counts a move sent to the server, along with its size (in bits) if it is known
+	void CountSentMove(int32 InNumBits);
+	// Logs the moves, bits and corrections counted since the last report, if the reports are enabled
+	void UpdateMovementReport(float InDeltaTime);
+
+//VARIABLES
+public:
+	// Whether moves are sent to the server less often while the input of the client doesn't change
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement (Networking)")
+		bool bUseAdaptiveNetSendRate;
+	/** Minimum time (in seconds) between the moves sent to the server while the input doesn't change.
+		The moves in between are combined into a single one */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement (Networking)", meta = (EditCondition = "bUseAdaptiveNetSendRate"))
+		float SteadyInputNetSendDeltaTime;
+
+private:
+	// Input of the last move sent to the server, to know whether it has changed since then
+	uint16 LastSentQuantizedAcceleration;
+	uint8 LastSentCompressedMoveFlags;
+	bool bHasSentQuantizedMove;
+	// Moves, bits and corrections counted since the last report
+	int32 NumReportedSentMoves;
+	int32 NumReportedSentBits;
+	int32 NumReportedReceivedMoves;
+	int32 NumReportedCorrections;
+	float ReportElapsedTimeInSeconds;
+};
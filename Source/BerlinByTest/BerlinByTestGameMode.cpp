@@ -2,14 +2,143 @@
 
 #include "BerlinByTestGameMode.h"
 #include "BerlinByTestCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "BerlinByTestPlayerController.h"
+#include "Core/MapPreloadManifest.h"
+#include "Engine/AssetManager.h"
+#include "Misc/CoreDelegates.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBerlinByTestStartup, Log, All);
+
+// Whether the time since the engine started has already been reported, as it is only meaningful for the first map
+static bool bHasReportedColdStartTime = false;
 
 ABerlinByTestGameMode::ABerlinByTestGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	/** Set default pawn class to our Blueprinted character. It is only referenced softly, so that the mesh, animations and
+		materials of the character are not loaded along with the game mode */
+	SoftDefaultPawnClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C")));
+	// The player controller lets play sessions be recorded and replayed
+	PlayerControllerClass = ABerlinByTestPlayerController::StaticClass();
+	bHaveStartupAssetsLoaded = false;
+	MapStartTime = 0.0;
+	StartupAssetsLoadedTime = 0.0;
+	bHasReportedStartupTimes = false;
+}
+
+void ABerlinByTestGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+	MapStartTime = FPlatformTime::Seconds();
+	// The manifest is loaded first, as it is what tells which assets the map needs
+	UAssetManager* const AssetManager = UAssetManager::GetIfValid();
+	MapPreloadManifestId = UMapPreloadManifest::GetMapManifestId(MapName);
+	if ((AssetManager != nullptr) && AssetManager->GetPrimaryAssetPath(MapPreloadManifestId).IsValid())
+	{
+		MapPreloadManifestHandle = AssetManager->LoadPrimaryAsset(MapPreloadManifestId, TArray<FName>(), FStreamableDelegate::CreateUObject(this, &ABerlinByTestGameMode::OnMapPreloadManifestLoaded));
+	}
+	else
+	{
+		OnMapPreloadManifestLoaded();
+	}
+}
+
+void ABerlinByTestGameMode::OnMapPreloadManifestLoaded()
+{
+	TArray<FSoftObjectPath> StartupAssetPaths;
+	if (!SoftDefaultPawnClass.IsNull())
+	{
+		StartupAssetPaths.Add(SoftDefaultPawnClass.ToSoftObjectPath());
+	}
+	UAssetManager* const AssetManager = UAssetManager::GetIfValid();
+	const UMapPreloadManifest* const MapPreloadManifest = (AssetManager != nullptr) ? AssetManager->GetPrimaryAssetObject<UMapPreloadManifest>(MapPreloadManifestId) : nullptr;
+	if (MapPreloadManifest != nullptr)
+	{
+		MapPreloadManifest->GetAssetPaths(StartupAssetPaths);
+	}
+	if (StartupAssetPaths.Num() > 0)
+	{
+		StartupAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(StartupAssetPaths, FStreamableDelegate::CreateUObject(this, &ABerlinByTestGameMode::OnStartupAssetsLoaded));
+	}
+	// Nothing is loaded if the assets were already in memory, e.g. after traveling to a map that needs the same ones
+	if (!StartupAssetsHandle.IsValid() || StartupAssetsHandle->HasLoadCompleted())
+	{
+		OnStartupAssetsLoaded();
+	}
+}
+
+void ABerlinByTestGameMode::OnStartupAssetsLoaded()
+{
+	if (bHaveStartupAssetsLoaded)
+	{
+		return;
+	}
+	bHaveStartupAssetsLoaded = true;
+	StartupAssetsLoadedTime = FPlatformTime::Seconds();
+	UClass* const LoadedPawnClass = SoftDefaultPawnClass.Get();
+	if (LoadedPawnClass != nullptr)
+	{
+		DefaultPawnClass = LoadedPawnClass;
+	}
+	// The players that joined meanwhile are spawned in the same order they joined
+	TArray<AController*> PlayersToRestart = MoveTemp(PendingRestartPlayers);
+	PendingRestartPlayers.Reset();
+	for (AController* const PlayerToRestart : PlayersToRestart)
+	{
+		if (PlayerToRestart->IsValidLowLevel() && !PlayerToRestart->IsPendingKill())
+		{
+			RestartPlayer(PlayerToRestart);
+		}
+	}
+}
+
+void ABerlinByTestGameMode::RestartPlayer(AController* NewPlayer)
+{
+	if (!bHaveStartupAssetsLoaded)
+	{
+		PendingRestartPlayers.AddUnique(NewPlayer);
+	}
+	else
+	{
+		Super::RestartPlayer(NewPlayer);
+		// The first frame in which a local player controls its pawn ends the startup
+		const APlayerController* const PlayerController = Cast<APlayerController>(NewPlayer);
+		if (!bHasReportedStartupTimes && !ReportStartupTimesHandle.IsValid() && (PlayerController != nullptr) && PlayerController->IsLocalController() && (PlayerController->GetPawn() != nullptr))
+		{
+			ReportStartupTimesHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &ABerlinByTestGameMode::ReportStartupTimes);
+		}
+	}
+}
+
+void ABerlinByTestGameMode::ReportStartupTimes()
+{
+	FCoreDelegates::OnEndFrame.Remove(ReportStartupTimesHandle);
+	ReportStartupTimesHandle.Reset();
+	bHasReportedStartupTimes = true;
+	const double FirstControllableFrameTime = FPlatformTime::Seconds();
+	if (!bHasReportedColdStartTime)
+	{
+		bHasReportedColdStartTime = true;
+		UE_LOG(LogBerlinByTestStartup, Display, TEXT("Engine init to first controllable frame: %.3f s (engine init to map start: %.3f s)"), FirstControllableFrameTime - GStartTime, MapStartTime - GStartTime);
+	}
+	UE_LOG(LogBerlinByTestStartup, Display, TEXT("Map start to first controllable frame: %.3f s (startup assets loaded after %.3f s)"), FirstControllableFrameTime - MapStartTime, StartupAssetsLoadedTime - MapStartTime);
+}
+
+void ABerlinByTestGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ReportStartupTimesHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(ReportStartupTimesHandle);
+		ReportStartupTimesHandle.Reset();
+	}
+	if (StartupAssetsHandle.IsValid())
+	{
+		StartupAssetsHandle->ReleaseHandle();
+		StartupAssetsHandle.Reset();
+	}
+	if (MapPreloadManifestHandle.IsValid())
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		MapPreloadManifestHandle->ReleaseHandle();
+		MapPreloadManifestHandle.Reset();
 	}
+	Super::EndPlay(EndPlayReason);
 }
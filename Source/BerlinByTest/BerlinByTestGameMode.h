@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "Engine/StreamableManager.h"
 #include "BerlinByTestGameMode.generated.h"
 
 UCLASS(minimalapi)
@@ -11,9 +12,47 @@ class ABerlinByTestGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
+//FUNCTIONS
 public:
 	ABerlinByTestGameMode();
-};
+	/** Starts loading the pawn class and the assets listed by the preload manifest of the map asynchronously,
+		so that the map doesn't wait for them to start */
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	// Delays spawning the pawn of a player until the startup assets have been loaded
+	virtual void RestartPlayer(AController* NewPlayer) override;
+
+protected:
+	// Called when the game mode is being removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+private:
+	// Called once the preload manifest of the map has been loaded, or right away if the map has none
+	void OnMapPreloadManifestLoaded();
+	// Called once the pawn class and the assets of the manifest have been loaded, spawning the players that were waiting for them
+	void OnStartupAssetsLoaded();
+	// Logs how long it took to reach the first frame in which a player controls its pawn
+	void ReportStartupTimes();
 
+//VARIABLES
+public:
+	/** Class of the pawn of the players. It is loaded asynchronously when the map starts instead of along with the game mode,
+		and the players are spawned once it has been loaded */
+	UPROPERTY(EditDefaultsOnly, Category = "Classes")
+		TSoftClassPtr<APawn> SoftDefaultPawnClass;
 
+private:
+	// Players waiting for the startup assets to be loaded to spawn their pawns
+	UPROPERTY()
+		TArray<AController*> PendingRestartPlayers;
+	// Keep the manifest and the startup assets loaded while the map is being played
+	TSharedPtr<FStreamableHandle> MapPreloadManifestHandle;
+	TSharedPtr<FStreamableHandle> StartupAssetsHandle;
+	FPrimaryAssetId MapPreloadManifestId;
+	bool bHaveStartupAssetsLoaded;
+	// Times (in seconds) at which the map started and its startup assets finished loading
+	double MapStartTime;
+	double StartupAssetsLoadedTime;
+	// Reports the startup times at the end of the first frame in which a player controls its pawn
+	FDelegateHandle ReportStartupTimesHandle;
+	bool bHasReportedStartupTimes;
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BerlinByTestPlayerController.h"
+#include "BerlinByTestCharacter.h"
+#include "Replay/SessionRecorder.h"
+
+// Called when the game starts
+void ABerlinByTestPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+	if (IsLocalController())
+	{
+		ASessionRecorder::StartFromCommandLine(this);
+	}
+}
+
+void ABerlinByTestPlayerController::ProcessPlayerInput(const float DeltaTime, const bool bGamePaused)
+{
+	ASessionRecorder* const SessionRecorder = ASessionRecorder::Get(this, false);
+	ABerlinByTestCharacter* const ControlledCharacter = Cast<ABerlinByTestCharacter>(GetPawn());
+	if (SessionRecorder->IsValidLowLevel() && SessionRecorder->IsReplaying())
+	{
+		// The recorded input replaces the live one, which is ignored
+		SessionRecorder->ReplayInputFrame(ControlledCharacter, DeltaTime);
+	}
+	else
+	{
+		// The shots fired by the input of this frame must be seen by the recorder to record their auto-aim decisions
+		if (SessionRecorder->IsValidLowLevel() && SessionRecorder->IsRecording())
+		{
+			SessionRecorder->BindCharacter(ControlledCharacter);
+		}
+		Super::ProcessPlayerInput(DeltaTime, bGamePaused);
+		if (ControlledCharacter != nullptr)
+		{
+			// The input of the character is consumed every frame, even if it isn't recorded, so that it doesn't pile up
+			const FCharacterInputFrame InputFrame = ControlledCharacter->ConsumeInputFrame();
+			if (SessionRecorder->IsValidLowLevel() && SessionRecorder->IsRecording())
+			{
+				SessionRecorder->RecordInputFrame(ControlledCharacter, InputFrame, DeltaTime);
+			}
+		}
+	}
+}
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "BerlinByTestPlayerController.generated.h"
+
+/** Player controller that lets play sessions be recorded and replayed: the input given to the possessed character
+	every frame is handed to the session recorder, or replaced by the recorded one while replaying */
+UCLASS()
+class BERLINBYTEST_API ABerlinByTestPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+	// Called every frame to process the input of the player
+	virtual void ProcessPlayerInput(const float DeltaTime, const bool bGamePaused) override;
+};
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AI/AISignificanceManager.h"
+#include "BerlinByTest.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "DrawDebugHelpers.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Camera/CameraComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "BerlinByTestCharacter.h"
+#include "Core/WorldSingleton.h"
+#include "Core/ScratchArray.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Significance"), STAT_AISignificance, STATGROUP_BerlinByTest);
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<int32> CVarShowAISignificance(
+	TEXT("BerlinByTest.AI.ShowSignificance"),
+	0,
+	TEXT("Draws the significance tier of every AI above it.\n")
+	TEXT("0: Off\n")
+	TEXT("1: On"),
+	ECVF_Cheat);
+#endif
+
+// Sets default values
+AAISignificanceManager::AAISignificanceManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	BehindCameraDistanceMultiplier = 2.f;
+	UpdateIntervalInSeconds = 0.25f;
+}
+
+AAISignificanceManager* AAISignificanceManager::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AAISignificanceManager>(WorldContextObject, bCreateIfMissing);
+}
+
+void AAISignificanceManager::BeginPlay()
+{
+	Super::BeginPlay();
+	// The tiers don't need to follow the AI every frame
+	SetActorTickInterval(UpdateIntervalInSeconds);
+}
+
+int32 AAISignificanceManager::GetSignificanceTier(const APawn* InPawn) const
+{
+	const int32* const TierIndex = TierIndicesByPawn.Find(InPawn);
+	return (TierIndex != nullptr) ? *TierIndex : INDEX_NONE;
+}
+
+int32 AAISignificanceManager::GetTierForDistance(float InDistance) const
+{
+	int32 TierIndex = Tiers.Num() - 1;
+	for (int32 CandidateTierIndex = 0; CandidateTierIndex < Tiers.Num(); ++CandidateTierIndex)
+	{
+		const float MaximumDistance = Tiers[CandidateTierIndex].MaximumDistance;
+		if ((MaximumDistance <= 0.f) || (InDistance < MaximumDistance))
+		{
+			TierIndex = CandidateTierIndex;
+			break;
+		}
+	}
+	return TierIndex;
+}
+
+void AAISignificanceManager::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(AI);
+	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_AISignificance);
+	UWorld* const CurrentWorld = GetWorld();
+	if (Tiers.Num() == 0)
+	{
+		return;
+	}
+	// Every player character is a viewer, so that AI are significant as long as any player can see them
+	FMemMark ScratchMark(FMemStack::Get());
+	TScratchArray<FTransform> ViewerTransforms;
+	for (TActorIterator<ABerlinByTestCharacter> CharacterIterator(CurrentWorld); CharacterIterator; ++CharacterIterator)
+	{
+		const UCameraComponent* const FollowCamera = CharacterIterator->GetFollowCamera();
+		ViewerTransforms.Add((FollowCamera != nullptr) ? FollowCamera->GetComponentTransform() : CharacterIterator->GetActorTransform());
+	}
+	// Without viewers, e.g. before the players spawn, every AI keeps its current tier
+	if (ViewerTransforms.Num() == 0)
+	{
+		return;
+	}
+	for (TActorIterator<APawn> PawnIterator(CurrentWorld); PawnIterator; ++PawnIterator)
+	{
+		APawn* const Pawn = *PawnIterator;
+		if ((Cast<AAIController>(Pawn->GetController()) == nullptr) || Pawn->IsPendingKill())
+		{
+			continue;
+		}
+		const FVector PawnLocation = Pawn->GetActorLocation();
+		float SignificanceDistance = TNumericLimits<float>::Max();
+		for (const FTransform& ViewerTransform : ViewerTransforms)
+		{
+			const FVector ViewerToPawn = PawnLocation - ViewerTransform.GetLocation();
+			float Distance = ViewerToPawn.Size();
+			if (FVector::DotProduct(ViewerToPawn, ViewerTransform.GetUnitAxis(EAxis::X)) < 0.f)
+			{
+				Distance *= BehindCameraDistanceMultiplier;
+			}
+			SignificanceDistance = FMath::Min(SignificanceDistance, Distance);
+		}
+		const int32 TierIndex = GetTierForDistance(SignificanceDistance);
+		// The settings of the AI only change when it moves to another tier
+		const int32* const CurrentTierIndex = TierIndicesByPawn.Find(Pawn);
+		if ((CurrentTierIndex == nullptr) || (*CurrentTierIndex != TierIndex))
+		{
+			TierIndicesByPawn.Add(Pawn, TierIndex);
+			ApplyTier(Pawn, TierIndex);
+		}
+#if !UE_BUILD_SHIPPING
+		if (CVarShowAISignificance.GetValueOnGameThread() != 0)
+		{
+			static const FColor TierColors[] = { FColor::Green, FColor::Yellow, FColor::Orange, FColor::Red, FColor::Purple };
+			const FColor TierColor = TierColors[FMath::Min(TierIndex, static_cast<int32>(ARRAY_COUNT(TierColors)) - 1)];
+			DrawDebugString(CurrentWorld, FVector(0.f, 0.f, 120.f), FString::Printf(TEXT("Tier %d"), TierIndex), Pawn, TierColor, UpdateIntervalInSeconds, true);
+		}
+#endif
+	}
+	// AI that are no longer in the world are forgotten
+	for (auto TierIterator = TierIndicesByPawn.CreateIterator(); TierIterator; ++TierIterator)
+	{
+		if (!TierIterator.Key().IsValid())
+		{
+			TierIterator.RemoveCurrent();
+		}
+	}
+}
+
+void AAISignificanceManager::ApplyTier(APawn* InPawn, int32 InTierIndex) const
+{
+	const FAISignificanceTier& Tier = Tiers[InTierIndex];
+	InPawn->SetActorTickInterval(Tier.ActorTickInterval);
+	UCharacterMovementComponent* const MovementComponent = Cast<UCharacterMovementComponent>(InPawn->GetMovementComponent());
+	if (MovementComponent != nullptr)
+	{
+		MovementComponent->SetComponentTickInterval(Tier.MovementTickInterval);
+		// Only walking AI switch between walking modes, so that falling or flying AI are left as they are
+		if (Tier.bUseNavWalking && (MovementComponent->MovementMode == MOVE_Walking))
+		{
+			MovementComponent->SetMovementMode(MOVE_NavWalking);
+		}
+		else if (!Tier.bUseNavWalking && (MovementComponent->MovementMode == MOVE_NavWalking))
+		{
+			MovementComponent->SetMovementMode(MOVE_Walking);
+		}
+	}
+	const AAIController* const AIController = Cast<AAIController>(InPawn->GetController());
+	UBrainComponent* const BrainComponent = (AIController != nullptr) ? AIController->GetBrainComponent() : nullptr;
+	if (BrainComponent != nullptr)
+	{
+		BrainComponent->SetComponentTickInterval(Tier.BehaviorTreeTickInterval);
+	}
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AI/BTDecorator_IsTargetClose.h"
+#include "AIController.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "GameFramework/Pawn.h"
+#include "AI/ProximityManager.h"
+
+// Memory of every instance of the decorator
+struct FBTIsTargetCloseMemory
+{
+	// Handle of the watch of the proximity manager while the decorator is relevant, or INDEX_NONE otherwise
+	int32 WatchHandle;
+};
+
+// Sets default values
+UBTDecorator_IsTargetClose::UBTDecorator_IsTargetClose(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	NodeName = TEXT("Is Target Close");
+	DistanceCloseEnoughForExplosion = 200.f;
+	bNotifyBecomeRelevant = true;
+	bNotifyCeaseRelevant = true;
+	bAllowAbortNone = true;
+	bAllowAbortLowerPri = true;
+	bAllowAbortChildNodes = true;
+	TargetKey.SelectedKeyName = TEXT("ActorToFollow");
+	TargetKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTDecorator_IsTargetClose, TargetKey), AActor::StaticClass());
+}
+
+void UBTDecorator_IsTargetClose::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+	const UBlackboardData* const BlackboardAsset = GetBlackboardAsset();
+	if (BlackboardAsset != nullptr)
+	{
+		TargetKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+uint16 UBTDecorator_IsTargetClose::GetInstanceMemorySize() const
+{
+	return sizeof(FBTIsTargetCloseMemory);
+}
+
+void UBTDecorator_IsTargetClose::InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const
+{
+	FBTIsTargetCloseMemory* const Memory = reinterpret_cast<FBTIsTargetCloseMemory*>(NodeMemory);
+	Memory->WatchHandle = INDEX_NONE;
+}
+
+void UBTDecorator_IsTargetClose::CleanupMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryClear::Type CleanupType) const
+{
+	// The tree can be stopped without the decorator ceasing to be relevant, in which case the watch is stopped here
+	FBTIsTargetCloseMemory* const Memory = reinterpret_cast<FBTIsTargetCloseMemory*>(NodeMemory);
+	AProximityManager* const ProximityManager = AProximityManager::Get(&OwnerComp, false);
+	if ((Memory->WatchHandle != INDEX_NONE) && ProximityManager->IsValidLowLevel())
+	{
+		ProximityManager->RemoveWatch(Memory->WatchHandle);
+	}
+	Memory->WatchHandle = INDEX_NONE;
+}
+
+bool UBTDecorator_IsTargetClose::CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const
+{
+	bool bIsTargetClose = false;
+	const FBTIsTargetCloseMemory* const Memory = reinterpret_cast<const FBTIsTargetCloseMemory*>(NodeMemory);
+	const AProximityManager* const ProximityManager = AProximityManager::Get(&OwnerComp, false);
+	if ((Memory != nullptr) && (Memory->WatchHandle != INDEX_NONE) && ProximityManager->IsValidLowLevel())
+	{
+		// While relevant, the state checked this frame by the proximity manager is used
+		bIsTargetClose = ProximityManager->IsTargetClose(Memory->WatchHandle);
+	}
+	else
+	{
+		const AAIController* const AIController = OwnerComp.GetAIOwner();
+		const UBlackboardComponent* const BlackboardComponent = OwnerComp.GetBlackboardComponent();
+		const APawn* const ControlledPawn = (AIController != nullptr) ? AIController->GetPawn() : nullptr;
+		const AActor* const Target = (BlackboardComponent != nullptr) ? Cast<AActor>(BlackboardComponent->GetValueAsObject(TargetKey.SelectedKeyName)) : nullptr;
+		if ((ControlledPawn != nullptr) && (Target != nullptr))
+		{
+			bIsTargetClose = (FVector::DistSquared(ControlledPawn->GetActorLocation(), Target->GetActorLocation()) < FMath::Square(DistanceCloseEnoughForExplosion));
+		}
+	}
+	return bIsTargetClose;
+}
+
+void UBTDecorator_IsTargetClose::OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTIsTargetCloseMemory* const Memory = reinterpret_cast<FBTIsTargetCloseMemory*>(NodeMemory);
+	Memory->WatchHandle = INDEX_NONE;
+	AProximityManager* const ProximityManager = AProximityManager::Get(&OwnerComp);
+	if (ProximityManager->IsValidLowLevel())
+	{
+		Memory->WatchHandle = ProximityManager->AddWatch(OwnerComp, this, TargetKey.GetSelectedKeyID(), DistanceCloseEnoughForExplosion);
+	}
+}
+
+void UBTDecorator_IsTargetClose::OnCeaseRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTIsTargetCloseMemory* const Memory = reinterpret_cast<FBTIsTargetCloseMemory*>(NodeMemory);
+	AProximityManager* const ProximityManager = AProximityManager::Get(&OwnerComp, false);
+	if ((Memory->WatchHandle != INDEX_NONE) && ProximityManager->IsValidLowLevel())
+	{
+		ProximityManager->RemoveWatch(Memory->WatchHandle);
+	}
+	Memory->WatchHandle = INDEX_NONE;
+}
+
+FString UBTDecorator_IsTargetClose::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("%s: %s is closer than %.1f"), *Super::GetStaticDescription(), *TargetKey.SelectedKeyName.ToString(), DistanceCloseEnoughForExplosion);
+}
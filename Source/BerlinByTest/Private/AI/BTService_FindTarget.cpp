@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AI/BTService_FindTarget.h"
+#include "BerlinByTest.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "GameFramework/Pawn.h"
+#include "AI/TargetSearchManager.h"
+#include "BerlinByTestCharacter.h"
+
+// Sets default values
+UBTService_FindTarget::UBTService_FindTarget(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	NodeName = TEXT("Find Target");
+	bNotifyTick = true;
+	Interval = 0.25f;
+	RandomDeviation = 0.1f;
+	MaximumResultAgeInSeconds = 0.5f;
+	// The AI chase the player characters by default
+	TargetClass = ABerlinByTestCharacter::StaticClass();
+	TargetKey.SelectedKeyName = TEXT("ActorToFollow");
+	TargetKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTService_FindTarget, TargetKey), AActor::StaticClass());
+	LastSeenLocationKey.SelectedKeyName = TEXT("LastSeenLocation");
+	LastSeenLocationKey.AddVectorFilter(this, GET_MEMBER_NAME_CHECKED(UBTService_FindTarget, LastSeenLocationKey));
+}
+
+void UBTService_FindTarget::InitializeFromAsset(UBehaviorTree& Asset)
+{
+	Super::InitializeFromAsset(Asset);
+	const UBlackboardData* const BlackboardAsset = GetBlackboardAsset();
+	if (BlackboardAsset != nullptr)
+	{
+		TargetKey.ResolveSelectedKey(*BlackboardAsset);
+		LastSeenLocationKey.ResolveSelectedKey(*BlackboardAsset);
+	}
+}
+
+void UBTService_FindTarget::TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(AI);
+	Super::TickNode(OwnerComp, NodeMemory, DeltaSeconds);
+	const AAIController* const AIController = OwnerComp.GetAIOwner();
+	UBlackboardComponent* const BlackboardComponent = OwnerComp.GetBlackboardComponent();
+	APawn* const ControlledPawn = (AIController != nullptr) ? AIController->GetPawn() : nullptr;
+	ATargetSearchManager* const TargetSearchManager = ATargetSearchManager::Get(ControlledPawn);
+	if (ControlledPawn->IsValidLowLevel() && (BlackboardComponent != nullptr) && TargetSearchManager->IsValidLowLevel())
+	{
+		// Until the first search of the cell is done there is no result, and the blackboard is left as it is
+		const FTargetSearchResult* const Result = TargetSearchManager->FindTarget(ControlledPawn, TargetClass, MaximumResultAgeInSeconds);
+		if (Result != nullptr)
+		{
+			AActor* const Target = Result->Target.Get();
+			BlackboardComponent->SetValueAsObject(TargetKey.SelectedKeyName, Target);
+			if (Target != nullptr)
+			{
+				BlackboardComponent->SetValueAsVector(LastSeenLocationKey.SelectedKeyName, Result->TargetLocation);
+			}
+		}
+	}
+}
+
+FString UBTService_FindTarget::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("%s: nearest visible %s\nStores it in %s and its location in %s"), *Super::GetStaticDescription(), *GetNameSafe(TargetClass.Get()), *TargetKey.SelectedKeyName.ToString(), *LastSeenLocationKey.SelectedKeyName.ToString());
+}
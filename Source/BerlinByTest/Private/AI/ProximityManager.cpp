@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AI/ProximityManager.h"
+#include "BerlinByTest.h"
+#include "AIController.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "BehaviorTree/BTDecorator.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "GameFramework/Pawn.h"
+#include "Core/WorldSingleton.h"
+#include "Core/ScratchArray.h"
+
+DECLARE_CYCLE_STAT(TEXT("Proximity Checks"), STAT_ProximityChecks, STATGROUP_BerlinByTest);
+
+// Sets default values
+AProximityManager::AProximityManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+AProximityManager* AProximityManager::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AProximityManager>(WorldContextObject, bCreateIfMissing);
+}
+
+int32 AProximityManager::AddWatch(UBehaviorTreeComponent& InOwnerComp, const UBTDecorator* InDecorator, FBlackboard::FKey InTargetKeyID, float InDistance)
+{
+	BERLINBYTEST_LLM_SCOPE(AI);
+	FProximityWatch Watch;
+	Watch.OwnerComp = &InOwnerComp;
+	Watch.Decorator = InDecorator;
+	Watch.TargetKeyID = InTargetKeyID;
+	Watch.SquaredDistance = FMath::Square(InDistance);
+	// The state is known from the start, so that the decorator can be evaluated before the next check
+	Watch.bIsTargetClose = ComputeIsTargetClose(Watch);
+	return Watches.Add(Watch);
+}
+
+void AProximityManager::RemoveWatch(int32 InWatchHandle)
+{
+	if (Watches.IsValidIndex(InWatchHandle))
+	{
+		Watches.RemoveAt(InWatchHandle);
+	}
+}
+
+bool AProximityManager::IsTargetClose(int32 InWatchHandle) const
+{
+	return Watches.IsValidIndex(InWatchHandle) && Watches[InWatchHandle].bIsTargetClose;
+}
+
+bool AProximityManager::ComputeIsTargetClose(const FProximityWatch& InWatch)
+{
+	bool bIsTargetClose = false;
+	const UBehaviorTreeComponent* const OwnerComp = InWatch.OwnerComp.Get();
+	if (OwnerComp != nullptr)
+	{
+		const AAIController* const AIController = OwnerComp->GetAIOwner();
+		const UBlackboardComponent* const BlackboardComponent = OwnerComp->GetBlackboardComponent();
+		const APawn* const ControlledPawn = (AIController != nullptr) ? AIController->GetPawn() : nullptr;
+		if ((ControlledPawn != nullptr) && (BlackboardComponent != nullptr))
+		{
+			const AActor* const Target = Cast<AActor>(BlackboardComponent->GetValue<UBlackboardKeyType_Object>(InWatch.TargetKeyID));
+			if (Target != nullptr)
+			{
+				bIsTargetClose = (FVector::DistSquared(ControlledPawn->GetActorLocation(), Target->GetActorLocation()) < InWatch.SquaredDistance);
+			}
+		}
+	}
+	return bIsTargetClose;
+}
+
+void AProximityManager::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(AI);
+	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_ProximityChecks);
+	// The trees are only notified once every watch has been checked, as they might add or remove watches in response
+	FMemMark ScratchMark(FMemStack::Get());
+	TScratchArray<TPair<TWeakObjectPtr<UBehaviorTreeComponent>, const UBTDecorator*>> FlippedWatches;
+	for (FProximityWatch& Watch : Watches)
+	{
+		const bool bIsTargetClose = ComputeIsTargetClose(Watch);
+		if (bIsTargetClose != Watch.bIsTargetClose)
+		{
+			Watch.bIsTargetClose = bIsTargetClose;
+			FlippedWatches.Add(TPair<TWeakObjectPtr<UBehaviorTreeComponent>, const UBTDecorator*>(Watch.OwnerComp, Watch.Decorator));
+		}
+	}
+	for (const TPair<TWeakObjectPtr<UBehaviorTreeComponent>, const UBTDecorator*>& FlippedWatch : FlippedWatches)
+	{
+		UBehaviorTreeComponent* const OwnerComp = FlippedWatch.Key.Get();
+		if (OwnerComp != nullptr)
+		{
+			OwnerComp->RequestExecution(const_cast<UBTDecorator*>(FlippedWatch.Value));
+		}
+	}
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AI/TargetSearchManager.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "Core/WorldSingleton.h"
+#include "Core/ScratchArray.h"
+
+DECLARE_CYCLE_STAT(TEXT("Target Searches"), STAT_TargetSearches, STATGROUP_BerlinByTest);
+
+// Sets default values
+ATargetSearchManager::ATargetSearchManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	CellSize = 1000.f;
+	MaximumSearchesPerFrame = 8;
+	SightTraceChannel = ECC_Visibility;
+	ResultLifetimeInSeconds = 10.f;
+	NextEvictionTimeInSeconds = 0.f;
+}
+
+ATargetSearchManager* ATargetSearchManager::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<ATargetSearchManager>(WorldContextObject, bCreateIfMissing);
+}
+
+FIntVector ATargetSearchManager::GetCell(const FVector& InLocation) const
+{
+	const float SafeCellSize = FMath::Max(CellSize, 1.f);
+	return FIntVector(FMath::FloorToInt(InLocation.X / SafeCellSize), FMath::FloorToInt(InLocation.Y / SafeCellSize), FMath::FloorToInt(InLocation.Z / SafeCellSize));
+}
+
+const FTargetSearchResult* ATargetSearchManager::FindTarget(APawn* InSearcher, TSubclassOf<AActor> InTargetClass, float InMaximumResultAgeInSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(AI);
+	const FTargetSearchResult* Result = nullptr;
+	UWorld* const CurrentWorld = GetWorld();
+	if (InSearcher->IsValidLowLevel() && (InTargetClass != nullptr) && CurrentWorld->IsValidLowLevel())
+	{
+		FTargetSearchKey Key;
+		Key.Cell = GetCell(InSearcher->GetActorLocation());
+		Key.TargetClass = InTargetClass.Get();
+		FTargetSearchResult* const FoundResult = Results.Find(Key);
+		bool bIsResultOutdated = true;
+		if (FoundResult != nullptr)
+		{
+			FoundResult->RequestTimeInSeconds = CurrentWorld->GetTimeSeconds();
+			// A target destroyed since the search makes the result outdated as well
+			bIsResultOutdated = FoundResult->Target.IsStale() || ((CurrentWorld->GetTimeSeconds() - FoundResult->SearchTimeInSeconds) > InMaximumResultAgeInSeconds);
+			Result = FoundResult;
+		}
+		// The first AI of the cell asking for a new result searches on behalf of the rest of them
+		if (bIsResultOutdated && !PendingKeys.Contains(Key))
+		{
+			FPendingTargetSearch PendingSearch;
+			PendingSearch.Searcher = InSearcher;
+			PendingSearch.Key = Key;
+			PendingSearches.Add(PendingSearch);
+			PendingKeys.Add(Key);
+		}
+	}
+	return Result;
+}
+
+void ATargetSearchManager::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(AI);
+	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_TargetSearches);
+	EvictUnusedResults();
+	const int32 NumSearches = (MaximumSearchesPerFrame > 0) ? FMath::Min(PendingSearches.Num(), MaximumSearchesPerFrame) : PendingSearches.Num();
+	if (NumSearches > 0)
+	{
+		// Targets are only gathered once per frame for every class, no matter how many searches use them
+		FMemMark ScratchMark(FMemStack::Get());
+		TMap<UClass*, TScratchArray<AActor*>> TargetsByClass;
+		for (int32 SearchIndex = 0; SearchIndex < NumSearches; ++SearchIndex)
+		{
+			const FPendingTargetSearch& PendingSearch = PendingSearches[SearchIndex];
+			PendingKeys.Remove(PendingSearch.Key);
+			UClass* const TargetClass = PendingSearch.Key.TargetClass.Get();
+			const APawn* const Searcher = PendingSearch.Searcher.Get();
+			if ((TargetClass != nullptr) && Searcher->IsValidLowLevel())
+			{
+				TScratchArray<AActor*>* Targets = TargetsByClass.Find(TargetClass);
+				if (Targets == nullptr)
+				{
+					Targets = &TargetsByClass.Add(TargetClass);
+					for (TActorIterator<AActor> ActorIterator(GetWorld(), TargetClass); ActorIterator; ++ActorIterator)
+					{
+						Targets->Add(*ActorIterator);
+					}
+				}
+				RunSearch(PendingSearch, *Targets);
+			}
+		}
+		PendingSearches.RemoveAt(0, NumSearches, false);
+	}
+}
+
+void ATargetSearchManager::EvictUnusedResults()
+{
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel() && (CurrentWorld->GetTimeSeconds() >= NextEvictionTimeInSeconds))
+	{
+		const float CurrentTimeInSeconds = CurrentWorld->GetTimeSeconds();
+		NextEvictionTimeInSeconds = CurrentTimeInSeconds + ResultLifetimeInSeconds;
+		for (auto ResultIterator = Results.CreateIterator(); ResultIterator; ++ResultIterator)
+		{
+			// Results waiting for a new search are kept, as the search will overwrite them anyway
+			const FTargetSearchResult& Result = ResultIterator.Value();
+			if (((CurrentTimeInSeconds - Result.RequestTimeInSeconds) > ResultLifetimeInSeconds) && !PendingKeys.Contains(ResultIterator.Key()))
+			{
+				ResultIterator.RemoveCurrent();
+			}
+		}
+	}
+}
+
+void ATargetSearchManager::RunSearch(const FPendingTargetSearch& InSearch, TArrayView<AActor* const> InTargets)
+{
+	UWorld* const CurrentWorld = GetWorld();
+	const APawn* const Searcher = InSearch.Searcher.Get();
+	FTargetSearchResult& Result = Results.FindOrAdd(InSearch.Key);
+	Result.SearchTimeInSeconds = CurrentWorld->GetTimeSeconds();
+	Result.RequestTimeInSeconds = Result.SearchTimeInSeconds;
+	Result.Target = nullptr;
+	const FVector SearcherLocation = Searcher->GetActorLocation();
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TargetSearch), false, Searcher);
+	// Targets are traced from the nearest to the furthest one, so the first visible one is the result
+	TScratchArray<AActor*> SortedTargets(InTargets.GetData(), InTargets.Num());
+	SortedTargets.Sort([&SearcherLocation](const AActor& A, const AActor& B)
+	{
+		return FVector::DistSquared(A.GetActorLocation(), SearcherLocation) < FVector::DistSquared(B.GetActorLocation(), SearcherLocation);
+	});
+	for (AActor* const Target : SortedTargets)
+	{
+		if (Target->IsValidLowLevel() && !Target->IsPendingKill())
+		{
+			FHitResult TraceHit;
+			CurrentWorld->LineTraceSingleByChannel(TraceHit, SearcherLocation, Target->GetActorLocation(), SightTraceChannel, QueryParams);
+			if (!TraceHit.bBlockingHit || (TraceHit.GetActor() == Target))
+			{
+				Result.Target = Target;
+				Result.TargetLocation = Target->GetActorLocation();
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,519 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Math/RandomStream.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Projectiles/AutoAimScoring.h"
+#include "Projectiles/ProjectileActor.h"
+#include "Projectiles/ProjectileShooterComponent.h"
+#include "Shootables/ProjectileObjective.h"
+#include "Shootables/ShootableRegistry.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogAutoAimBenchmark, Log, All);
+
+static TAutoConsoleVariable<int32> CVarAutoAimBenchmarkIterations(
+	TEXT("BerlinByTest.Benchmark.AutoAim.Iterations"),
+	200,
+	TEXT("How many times every function is timed by the auto-aim benchmark for each grid size."),
+	ECVF_Default);
+
+// Maximum difference between a score and the reference one, which covers the error of the vectorized math
+static const float AutoAimScoreTolerance = 1.e-3f;
+
+/** Spawns a grid of objectives in front of a shooter in a world of its own, checks that the targets and scores chosen by the shooter
+	match the ones of a reference implementation, and optionally times the auto-aim and shooting paths.
+	Mismatches are reported as errors of the automation test running it, so that automated runs fail on them. The tests run headless, e.g.:
+	UE4Editor-Cmd BerlinByTest -nullrhi -unattended -nopause -ExecCmds="Automation RunTests BerlinByTest.AutoAim+BerlinByTest.Benchmark.AutoAim; Quit" */
+class FAutoAimBenchmark
+{
+public:
+	FAutoAimBenchmark(FAutomationTestBase& InTest, int32 InGridSize, int32 InNumChecks, int32 InNumIterations)
+		: Test(InTest)
+		, GridSize(InGridSize)
+		, NumChecks(InNumChecks)
+		, NumIterations(InNumIterations)
+		, World(nullptr)
+		, Shooter(nullptr)
+		, ShooterOwner(nullptr)
+		, RandomStream(12345)
+		, NumMismatches(0)
+	{
+	}
+
+	// Runs the checks, and the measurements if there are iterations to time, returning false if the world couldn't be set up
+	bool Run()
+	{
+		bool bHasRun = false;
+		if (CreateWorld())
+		{
+			CreateShooter();
+			SpawnObjectiveGrid();
+			if (ShooterOwner->IsValidLowLevel() && (Objectives.Num() == GridSize))
+			{
+				CheckScores();
+				CheckChosenTargets();
+				if (NumIterations > 0)
+				{
+					MeasureScoring();
+					MeasureCenteredShootableActor();
+					MeasureShoot();
+					WriteReports();
+				}
+				bHasRun = true;
+			}
+			DestroyWorld();
+		}
+		return bHasRun;
+	}
+
+private:
+	// Timings of a single measured function
+	struct FBenchmarkResult
+	{
+		FString Name;
+		int32 NumCandidates;
+		TArray<double> SamplesInMilliseconds;
+
+		double GetPercentile(float InPercentile) const
+		{
+			// The samples are sorted before the results are reported
+			const int32 SampleIndex = FMath::Clamp(FMath::CeilToInt(InPercentile * SamplesInMilliseconds.Num()) - 1, 0, SamplesInMilliseconds.Num() - 1);
+			return SamplesInMilliseconds.Num() > 0 ? SamplesInMilliseconds[SampleIndex] : 0.0;
+		}
+
+		double GetMean() const
+		{
+			double Sum = 0.0;
+			for (const double Sample : SamplesInMilliseconds)
+			{
+				Sum += Sample;
+			}
+			return SamplesInMilliseconds.Num() > 0 ? Sum / SamplesInMilliseconds.Num() : 0.0;
+		}
+	};
+
+	/** Creates a game world of its own, so that nothing else in the current one can change the chosen targets,
+		and the test doesn't need a map to be loaded */
+	bool CreateWorld()
+	{
+		if (GEngine != nullptr)
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false);
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+			// Without a game mode nothing starts the play of the actors, which the shooter needs to get its ammo
+			World->GetWorldSettings()->NotifyBeginPlay();
+		}
+		return World->IsValidLowLevel();
+	}
+
+	void DestroyWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World = nullptr;
+		Shooter = nullptr;
+		ShooterOwner = nullptr;
+		Objectives.Reset();
+	}
+
+	void CreateShooter()
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		// Without a controller, the control rotation of the pawn looks along the X axis
+		ShooterOwner = World->SpawnActor<APawn>(APawn::StaticClass(), FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+		if (ShooterOwner->IsValidLowLevel())
+		{
+			Shooter = NewObject<UProjectileShooterComponent>(ShooterOwner);
+			// Every term of the score is used, so that none of them is skipped by the batch scoring
+			Shooter->PriorityWeight = 1.f;
+			Shooter->DistanceWeight = 1.f;
+			Shooter->FocusWeight = 1.f;
+			Shooter->MaximumDistance = 20000.f;
+			Shooter->MaximumVisionAngle = 30.f;
+			// The reference traces every candidate it needs to, so the shooter must be allowed to as well
+			Shooter->MaximumOcclusionTracesPerShot = 0;
+			// Target tracking would keep the previous target instead of scoring the candidates, so it is only used to measure it
+			Shooter->bUseAutoAimTargetTracking = false;
+			Shooter->InitialAmmo = TNumericLimits<int32>::Max();
+			Shooter->MaximumAmmo = TNumericLimits<int32>::Max();
+			Shooter->ProjectileClass = AProjectileActor::StaticClass();
+			Shooter->RegisterComponent();
+		}
+	}
+
+	// Spawns the objectives in a square grid in front of the shooter, with random priorities
+	void SpawnObjectiveGrid()
+	{
+		UStaticMesh* const CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		const int32 GridSide = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(GridSize)));
+		const float Spacing = 200.f;
+		Objectives.Reserve(GridSize);
+		for (int32 ObjectiveIndex = 0; ObjectiveIndex < GridSize; ++ObjectiveIndex)
+		{
+			const FTransform Transform(FVector(500.f + (ObjectiveIndex / GridSide) * Spacing, ((ObjectiveIndex % GridSide) - GridSide * 0.5f) * Spacing, 0.f));
+			// The priority is set before the objective starts playing, which is when it registers as a shootable
+			AProjectileObjective* const Objective = World->SpawnActorDeferred<AProjectileObjective>(AProjectileObjective::StaticClass(), Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (Objective->IsValidLowLevel())
+			{
+				// The objectives need collision for the occlusion traces to find them
+				if (CubeMesh != nullptr)
+				{
+					Objective->MeshComponent->SetStaticMesh(CubeMesh);
+				}
+				Objective->AutoAimPriority = RandomStream.FRandRange(0.f, 10.f);
+				Objective->FinishSpawning(Transform);
+				Objectives.Add(Objective);
+			}
+		}
+	}
+
+	// Moves the shooter around the front of the grid, so that every iteration sees a different set of candidates
+	void MoveShooterToRandomLocation()
+	{
+		ShooterOwner->SetActorLocation(FVector(RandomStream.FRandRange(-2000.f, 0.f), RandomStream.FRandRange(-2000.f, 2000.f), 0.f));
+	}
+
+	FVector GetShooterForwardVector() const
+	{
+		return UKismetMathLibrary::GetForwardVector(ShooterOwner->GetControlRotation()).GetSafeNormal();
+	}
+
+	// Returns the auto-aim priority the shootable registry stores for an objective, which is the one shooters score it with
+	float GetRegisteredPriority(const AProjectileObjective* InObjective) const
+	{
+		const AShootableRegistry* const ShootableRegistry = AShootableRegistry::Get(World, false);
+		return ShootableRegistry->IsValidLowLevel() ? ShootableRegistry->GetShootablePriority(InObjective) : 0.f;
+	}
+
+	/** Reference auto-aim score, written from what the weights of the shooter are documented to do instead of from its code:
+		each term goes from 0 to 1 and the score is their average, weighted by the weights of the shooter.
+		Objectives outside the maximum distance or angle of vision score 0 */
+	float GetReferenceScore(const AProjectileObjective* InObjective) const
+	{
+		float ReferenceScore = 0.f;
+		const FVector ToObjective = InObjective->GetActorLocation() - ShooterOwner->GetActorLocation();
+		const float Distance = ToObjective.Size();
+		if (Distance > 0.f)
+		{
+			const float AngleInDegrees = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(ToObjective / Distance, GetShooterForwardVector()), -1.f, 1.f)));
+			const bool bIsWithinDistance = (Shooter->MaximumDistance <= 0.f) || (Distance < Shooter->MaximumDistance);
+			if (bIsWithinDistance && (AngleInDegrees < Shooter->MaximumVisionAngle))
+			{
+				// 1 when the objective is centered and 0 at the edge of the angle of vision, proportionally to the cosine of the angle
+				const float CosineOfMaximumVisionAngle = FMath::Cos(FMath::DegreesToRadians(Shooter->MaximumVisionAngle));
+				const float Focus = (FMath::Cos(FMath::DegreesToRadians(AngleInDegrees)) - CosineOfMaximumVisionAngle) / (1.f - CosineOfMaximumVisionAngle);
+				// 1 for the highest priority and 0 for the lowest one
+				const float Priority = FMath::Clamp(InObjective->AutoAimPriority, 0.f, 10.f) / 10.f;
+				float WeightedSum = Focus * Shooter->FocusWeight + Priority * Shooter->PriorityWeight;
+				float SumOfWeights = Shooter->FocusWeight + Shooter->PriorityWeight;
+				// 1 right at the shooter and 0 at the maximum distance, which only counts if there is one
+				if (Shooter->MaximumDistance > 0.f)
+				{
+					WeightedSum += (1.f - Distance / Shooter->MaximumDistance) * Shooter->DistanceWeight;
+					SumOfWeights += Shooter->DistanceWeight;
+				}
+				ReferenceScore = (SumOfWeights > 0.f) ? WeightedSum / SumOfWeights : 0.f;
+			}
+		}
+		return ReferenceScore;
+	}
+
+	/** Reference auto-aim target: the visible objective with the highest reference score. The objectives are visited
+		in no particular order, and only the ones that would beat the best visible one found so far are traced */
+	const AProjectileObjective* FindReferenceTarget(float& OutReferenceScore) const
+	{
+		const AProjectileObjective* ReferenceTarget = nullptr;
+		OutReferenceScore = 0.f;
+		const FVector OwnerLocation = ShooterOwner->GetActorLocation();
+		for (const AProjectileObjective* const Objective : Objectives)
+		{
+			const float ReferenceScore = GetReferenceScore(Objective);
+			if (ReferenceScore > OutReferenceScore)
+			{
+				FHitResult TraceHit;
+				World->LineTraceSingleByChannel(TraceHit, OwnerLocation, Objective->GetActorLocation(), ECC_GameTraceChannel2);
+				if (TraceHit.GetActor() == Objective)
+				{
+					ReferenceTarget = Objective;
+					OutReferenceScore = ReferenceScore;
+				}
+			}
+		}
+		return ReferenceTarget;
+	}
+
+	/** Checks that the registry stores the clamped priority of every objective, including the ones changed through
+		SetAutoAimPriority, and that the batch and scalar scores of every objective, computed with that priority, match its reference score */
+	void CheckScores()
+	{
+		// Some priorities are changed after the objectives have been registered, a few of them out of range, so that the registry has to follow them
+		for (int32 ObjectiveIndex = 0; ObjectiveIndex < Objectives.Num(); ObjectiveIndex += 7)
+		{
+			Objectives[ObjectiveIndex]->SetAutoAimPriority(RandomStream.FRandRange(-2.f, 12.f));
+		}
+		const int32 NumScoreChecks = FMath::Min(NumChecks, 10);
+		const float CosineOfMaximumVisionAngle = FGenericPlatformMath::Cos(FMath::DegreesToRadians(Shooter->MaximumVisionAngle));
+		int32 NumScoreMismatches = 0;
+		FMemMark ScratchMark(FMemStack::Get());
+		FAutoAimCandidateBatch CandidateBatch;
+		CandidateBatch.Reserve(Objectives.Num());
+		for (AProjectileObjective* const Objective : Objectives)
+		{
+			const float RegisteredPriority = GetRegisteredPriority(Objective);
+			if (!FMath::IsNearlyEqual(RegisteredPriority, FMath::Clamp(Objective->AutoAimPriority, 0.f, 10.f)))
+			{
+				if (NumScoreMismatches < 10)
+				{
+					Test.AddError(FString::Printf(TEXT("Grid of %d objectives: the registry stores a priority of %f for %s, whose priority is %f"), GridSize, RegisteredPriority, *Objective->GetName(), Objective->AutoAimPriority));
+				}
+				++NumScoreMismatches;
+			}
+			CandidateBatch.Add(Objective, Objective->GetActorLocation(), RegisteredPriority);
+		}
+		TArray<float> BatchScores;
+		BatchScores.SetNumUninitialized(CandidateBatch.Num());
+		for (int32 CheckIndex = 0; CheckIndex < NumScoreChecks; ++CheckIndex)
+		{
+			MoveShooterToRandomLocation();
+			const FVector OwnerLocation = ShooterOwner->GetActorLocation();
+			const FVector OwnerForwardVector = GetShooterForwardVector();
+			ScoreAutoAimCandidates(FAutoAimScoringParameters::Make(OwnerLocation, OwnerForwardVector, Shooter->MaximumVisionAngle, Shooter->MaximumDistance, Shooter->PriorityWeight, Shooter->DistanceWeight, Shooter->FocusWeight), CandidateBatch, BatchScores);
+			for (int32 ObjectiveIndex = 0; ObjectiveIndex < Objectives.Num(); ++ObjectiveIndex)
+			{
+				const float ReferenceScore = GetReferenceScore(Objectives[ObjectiveIndex]);
+				// The scalar score doesn't check the distance and angle of vision, which the registry does before scoring
+				FVector VectorToObjective = CandidateBatch.GetLocation(ObjectiveIndex) - OwnerLocation;
+				const float DistanceToObjective = VectorToObjective.Size();
+				VectorToObjective.Normalize();
+				const float ScalarScore = (ReferenceScore > 0.f) ? Shooter->GetAutoAimScoreForTesting(CandidateBatch.Priorities[ObjectiveIndex], DistanceToObjective, FVector::DotProduct(VectorToObjective, OwnerForwardVector), CosineOfMaximumVisionAngle) : 0.f;
+				if (!FMath::IsNearlyEqual(BatchScores[ObjectiveIndex], ReferenceScore, AutoAimScoreTolerance) || !FMath::IsNearlyEqual(ScalarScore, ReferenceScore, AutoAimScoreTolerance))
+				{
+					// Every mismatch is logged, but only the first few are reported as errors to keep the report readable
+					if (NumScoreMismatches < 10)
+					{
+						Test.AddError(FString::Printf(TEXT("Grid of %d objectives: %s scored %f with batch scoring and %f with scalar scoring, but %f with the reference"), GridSize, *Objectives[ObjectiveIndex]->GetName(), BatchScores[ObjectiveIndex], ScalarScore, ReferenceScore));
+					}
+					++NumScoreMismatches;
+				}
+			}
+		}
+		if (NumScoreMismatches > 0)
+		{
+			Test.AddError(FString::Printf(TEXT("Grid of %d objectives: %d priorities and scores didn't match the reference"), GridSize, NumScoreMismatches));
+		}
+		NumMismatches += NumScoreMismatches;
+	}
+
+	/** Compares the target chosen by both scoring paths with the reference one. Targets whose reference scores only differ
+		by floating point error are considered a match, as the order of ties is not defined */
+	void CheckChosenTargets()
+	{
+		int32 NumTargetMismatches = 0;
+		for (int32 CheckIndex = 0; CheckIndex < NumChecks; ++CheckIndex)
+		{
+			MoveShooterToRandomLocation();
+			float ReferenceScore;
+			const AProjectileObjective* const ReferenceTarget = FindReferenceTarget(ReferenceScore);
+			for (const bool bUseBatchAutoAimScoring : { true, false })
+			{
+				Shooter->bUseBatchAutoAimScoring = bUseBatchAutoAimScoring;
+				const AProjectileObjective* const ChosenTarget = Cast<AProjectileObjective>(Shooter->GetCenteredShootableActorForTesting());
+				const bool bIsMatch = (ChosenTarget == ReferenceTarget) || ((ChosenTarget != nullptr) && (ReferenceTarget != nullptr) && FMath::IsNearlyEqual(GetReferenceScore(ChosenTarget), ReferenceScore, AutoAimScoreTolerance));
+				if (!bIsMatch)
+				{
+					++NumTargetMismatches;
+					Test.AddError(FString::Printf(TEXT("Grid of %d objectives: %s scoring chose %s but the reference chose %s"), GridSize, bUseBatchAutoAimScoring ? TEXT("batch") : TEXT("scalar"), *GetNameSafe(ChosenTarget), *GetNameSafe(ReferenceTarget)));
+				}
+			}
+		}
+		Shooter->bUseBatchAutoAimScoring = true;
+		NumMismatches += NumTargetMismatches;
+		UE_LOG(LogAutoAimBenchmark, Display, TEXT("Grid of %d objectives: %d of %d chosen targets matched the reference"), GridSize, NumChecks * 2 - NumTargetMismatches, NumChecks * 2);
+	}
+
+	// Times scoring every objective of the grid with the batch scoring and with the scalar one
+	void MeasureScoring()
+	{
+		const FVector OwnerLocation = ShooterOwner->GetActorLocation();
+		const FVector OwnerForwardVector = GetShooterForwardVector();
+		const float CosineOfMaximumVisionAngle = FGenericPlatformMath::Cos(FMath::DegreesToRadians(Shooter->MaximumVisionAngle));
+		FMemMark ScratchMark(FMemStack::Get());
+		FAutoAimCandidateBatch CandidateBatch;
+		CandidateBatch.Reserve(Objectives.Num());
+		for (AProjectileObjective* const Objective : Objectives)
+		{
+			CandidateBatch.Add(Objective, Objective->GetActorLocation(), GetRegisteredPriority(Objective));
+		}
+		const FAutoAimScoringParameters ScoringParameters = FAutoAimScoringParameters::Make(OwnerLocation, OwnerForwardVector, Shooter->MaximumVisionAngle, Shooter->MaximumDistance, Shooter->PriorityWeight, Shooter->DistanceWeight, Shooter->FocusWeight);
+		TArray<float> Scores;
+		Scores.SetNumUninitialized(CandidateBatch.Num());
+		FBenchmarkResult& BatchResult = AddResult(TEXT("ScoreAutoAimCandidates"), CandidateBatch.Num());
+		FBenchmarkResult& ScalarResult = AddResult(TEXT("GetAutoAimScore"), CandidateBatch.Num());
+		for (int32 IterationIndex = 0; IterationIndex < NumIterations; ++IterationIndex)
+		{
+			const uint64 BatchStartCycles = FPlatformTime::Cycles64();
+			ScoreAutoAimCandidates(ScoringParameters, CandidateBatch, Scores);
+			BatchResult.SamplesInMilliseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - BatchStartCycles));
+
+			const uint64 ScalarStartCycles = FPlatformTime::Cycles64();
+			for (int32 CandidateIndex = 0; CandidateIndex < CandidateBatch.Num(); ++CandidateIndex)
+			{
+				FVector VectorToCandidate = CandidateBatch.GetLocation(CandidateIndex) - OwnerLocation;
+				const float DistanceToCandidate = VectorToCandidate.Size();
+				VectorToCandidate.Normalize();
+				Scores[CandidateIndex] = Shooter->GetAutoAimScoreForTesting(CandidateBatch.Priorities[CandidateIndex], DistanceToCandidate, FVector::DotProduct(VectorToCandidate, OwnerForwardVector), CosineOfMaximumVisionAngle);
+			}
+			ScalarResult.SamplesInMilliseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - ScalarStartCycles));
+		}
+	}
+
+	// Times the whole auto-aim search, including the registry query, the scoring and the occlusion traces
+	void MeasureCenteredShootableActor()
+	{
+		for (const bool bUseBatchAutoAimScoring : { true, false })
+		{
+			Shooter->bUseBatchAutoAimScoring = bUseBatchAutoAimScoring;
+			FBenchmarkResult& Result = AddResult(bUseBatchAutoAimScoring ? TEXT("GetCenteredShootableActor (batch)") : TEXT("GetCenteredShootableActor (scalar)"), 0);
+			for (int32 IterationIndex = 0; IterationIndex < NumIterations; ++IterationIndex)
+			{
+				MoveShooterToRandomLocation();
+				Result.NumCandidates = FMath::Max(Result.NumCandidates, Shooter->GetNumAutoAimCandidatesForTesting());
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				Shooter->GetCenteredShootableActorForTesting();
+				Result.SamplesInMilliseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+			}
+		}
+		Shooter->bUseBatchAutoAimScoring = true;
+	}
+
+	/** Times full shots with batch and scalar scoring, without target tracking so that every shot scores the candidates,
+		and then with target tracking on its own */
+	void MeasureShoot()
+	{
+		MeasureShoot(TEXT("Shoot (batch)"), true, false);
+		MeasureShoot(TEXT("Shoot (scalar)"), false, false);
+		MeasureShoot(TEXT("Shoot (tracking)"), true, true);
+		Shooter->bUseBatchAutoAimScoring = true;
+		Shooter->bUseAutoAimTargetTracking = false;
+	}
+
+	void MeasureShoot(const TCHAR* InName, bool bInUseBatchAutoAimScoring, bool bInUseAutoAimTargetTracking)
+	{
+		Shooter->bUseBatchAutoAimScoring = bInUseBatchAutoAimScoring;
+		Shooter->bUseAutoAimTargetTracking = bInUseAutoAimTargetTracking;
+		FBenchmarkResult& Result = AddResult(InName, 0);
+		for (int32 IterationIndex = 0; IterationIndex < NumIterations; ++IterationIndex)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Shooter->Shoot();
+			Result.SamplesInMilliseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+		}
+	}
+
+	FBenchmarkResult& AddResult(const TCHAR* InName, int32 InNumCandidates)
+	{
+		FBenchmarkResult Result;
+		Result.Name = InName;
+		Result.NumCandidates = InNumCandidates;
+		Result.SamplesInMilliseconds.Reserve(NumIterations);
+		const int32 ResultIndex = Results.Add(Result);
+		return Results[ResultIndex];
+	}
+
+	// Writes every result as CSV and JSON to the Saved/Benchmarks folder of the project
+	void WriteReports()
+	{
+		FString Csv = TEXT("Name,GridSize,Candidates,Samples,MeanMs,P50Ms,P90Ms,P99Ms,MaxMs\n");
+		FString Json = FString::Printf(TEXT("{\n\t\"gridSize\": %d,\n\t\"iterations\": %d,\n\t\"mismatches\": %d,\n\t\"results\": [\n"), GridSize, NumIterations, NumMismatches);
+		for (int32 ResultIndex = 0; ResultIndex < Results.Num(); ++ResultIndex)
+		{
+			FBenchmarkResult& Result = Results[ResultIndex];
+			Result.SamplesInMilliseconds.Sort();
+			const double Mean = Result.GetMean();
+			const double P50 = Result.GetPercentile(0.5f);
+			const double P90 = Result.GetPercentile(0.9f);
+			const double P99 = Result.GetPercentile(0.99f);
+			const double Max = Result.GetPercentile(1.f);
+			Csv += FString::Printf(TEXT("%s,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f\n"), *Result.Name, GridSize, Result.NumCandidates, Result.SamplesInMilliseconds.Num(), Mean, P50, P90, P99, Max);
+			Json += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"candidates\": %d, \"samples\": %d, \"meanMs\": %.6f, \"p50Ms\": %.6f, \"p90Ms\": %.6f, \"p99Ms\": %.6f, \"maxMs\": %.6f }%s\n"), *Result.Name, Result.NumCandidates, Result.SamplesInMilliseconds.Num(), Mean, P50, P90, P99, Max, (ResultIndex < Results.Num() - 1) ? TEXT(",") : TEXT(""));
+			UE_LOG(LogAutoAimBenchmark, Display, TEXT("%-36s %7d objectives: mean %.4f ms, p50 %.4f ms, p90 %.4f ms, p99 %.4f ms"), *Result.Name, GridSize, Mean, P50, P90, P99);
+		}
+		Json += TEXT("\t]\n}\n");
+		const FString ReportPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), FString::Printf(TEXT("AutoAim-%d-%s"), GridSize, *FDateTime::Now().ToString()));
+		FFileHelper::SaveStringToFile(Csv, *(ReportPath + TEXT(".csv")));
+		FFileHelper::SaveStringToFile(Json, *(ReportPath + TEXT(".json")));
+		Test.AddInfo(FString::Printf(TEXT("Auto-aim benchmark report written to %s.csv and %s.json"), *ReportPath, *ReportPath));
+	}
+
+	FAutomationTestBase& Test;
+	int32 GridSize;
+	int32 NumChecks;
+	int32 NumIterations;
+	UWorld* World;
+	UProjectileShooterComponent* Shooter;
+	APawn* ShooterOwner;
+	TArray<AProjectileObjective*> Objectives;
+	FRandomStream RandomStream;
+	TArray<FBenchmarkResult> Results;
+	// Scores and chosen targets that didn't match the reference, which are also reported as errors of the test
+	int32 NumMismatches;
+};
+
+// Adds a variant of a test for every grid size, whose amount of objectives is passed to the test as its parameters
+static void GetAutoAimGridSizeTests(std::initializer_list<int32> InGridSizes, TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands)
+{
+	for (const int32 GridSize : InGridSizes)
+	{
+		OutBeautifiedNames.Add(FString::Printf(TEXT("%d Objectives"), GridSize));
+		OutTestCommands.Add(FString::FromInt(GridSize));
+	}
+}
+
+// Checks that the auto-aim of the shooter chooses the same targets and scores as the reference implementation
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FAutoAimMatchesReferenceTest, "BerlinByTest.AutoAim.MatchesReference", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+void FAutoAimMatchesReferenceTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	GetAutoAimGridSizeTests({ 100, 1000, 10000 }, OutBeautifiedNames, OutTestCommands);
+}
+
+bool FAutoAimMatchesReferenceTest::RunTest(const FString& Parameters)
+{
+	FAutoAimBenchmark Benchmark(*this, FMath::Max(FCString::Atoi(*Parameters), 1), 50, 0);
+	return Benchmark.Run();
+}
+
+/** Times the auto-aim and shooting paths, after checking them against the reference implementation, and writes the timings
+	to Saved/Benchmarks. The amount of iterations is set with BerlinByTest.Benchmark.AutoAim.Iterations */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FAutoAimBenchmarkTest, "BerlinByTest.Benchmark.AutoAim", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FAutoAimBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	GetAutoAimGridSizeTests({ 100, 1000, 10000, 100000 }, OutBeautifiedNames, OutTestCommands);
+}
+
+bool FAutoAimBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FAutoAimBenchmark Benchmark(*this, FMath::Max(FCString::Atoi(*Parameters), 1), 50, FMath::Max(CVarAutoAimBenchmarkIterations.GetValueOnGameThread(), 1));
+	return Benchmark.Run();
+}
+
+#endif
@@ -0,0 +1,424 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Tickable.h"
+#include "BerlinByTestCharacter.h"
+#include "Projectiles/ProjectilePool.h"
+#include "Projectiles/ProjectileShooterComponent.h"
+#include "Projectiles/ProjectileSimulationManager.h"
+#include "Shootables/ProjectileObjective.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHordeStressTest, Log, All);
+
+// Settings of a horde stress test, given by the arguments of its console command
+struct FHordeStressTestSettings
+{
+	int32 NumAI = 200;
+	int32 NumObjectives = 1000;
+	float DurationInSeconds = 1800.f;
+	float BurstsPerSecond = 10.f;
+	int32 NumShooters = 8;
+	int32 BurstSize = 3;
+	bool bShouldQuit = false;
+};
+
+/** Soak test that keeps a horde of AI, a field of objectives and a group of shooters firing bursts at a fixed rate
+	for a set duration, writing the time, actors, projectiles and memory of every frame to Saved/Benchmarks as it goes.
+	Growth of the frame time or the memory between the start and the end of a long run is what nightly jobs look for,
+	so the rows are streamed to the file instead of being kept in memory. It runs in the current game world, e.g.:
+	UE4Editor BerlinByTest /Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap -game -nullrhi -unattended -ExecCmds="BerlinByTest.Benchmark.Horde 200 1000 1800 10 8 Quit" */
+class FHordeStressTest : public FTickableGameObject
+{
+public:
+	FHordeStressTest(UWorld* InWorld, const FHordeStressTestSettings& InSettings)
+		: World(InWorld)
+		, Settings(InSettings)
+		, RandomStream(12345)
+		, StartTimeInSeconds(0.0)
+		, BeginFrameTimeInSeconds(0.0)
+		, NumFrames(0)
+		, PendingBursts(0.f)
+		, NextShooterIndex(0)
+		, NumBursts(0)
+		, NumRejectedBursts(0)
+		, NumRequestedShots(0)
+		, NumFiredShots(0)
+		, StartUsedPhysicalMemory(0)
+		, FirstTenthGameThreadTime(0.0)
+		, NumFirstTenthFrames(0)
+		, LastTenthGameThreadTime(0.0)
+		, NumLastTenthFrames(0)
+		, bIsFinished(false)
+	{
+	}
+
+	virtual ~FHordeStressTest()
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	}
+
+	// Spawns the horde and starts writing the report, returning false if the report can't be written
+	bool Start()
+	{
+		ReportPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), FString::Printf(TEXT("Horde-%s.csv"), *FDateTime::Now().ToString()));
+		ReportWriter.Reset(IFileManager::Get().CreateFileWriter(*ReportPath));
+		if (!ReportWriter.IsValid())
+		{
+			UE_LOG(LogHordeStressTest, Error, TEXT("The horde stress test report couldn't be created at %s"), *ReportPath);
+			return false;
+		}
+		WriteReportLine(TEXT("Frame,TimeSeconds,FrameMs,GameThreadMs,Actors,AI,Objectives,PooledProjectiles,SimulatedProjectiles,Bursts,RejectedBursts,RequestedShots,FiredShots,UsedPhysicalMB,UsedVirtualMB"));
+		SpawnHorde();
+		StartTimeInSeconds = FPlatformTime::Seconds();
+		StartUsedPhysicalMemory = FPlatformMemory::GetStats().UsedPhysical;
+		BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FHordeStressTest::OnBeginFrame);
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FHordeStressTest::OnEndFrame);
+		UE_LOG(LogHordeStressTest, Display, TEXT("Horde stress test started with %d AI, %d objectives and %d shooters for %.0f seconds"), AI.Num(), Objectives.Num(), Shooters.Num(), Settings.DurationInSeconds);
+		return true;
+	}
+
+	// Returns true once the test has ended and written its report
+	bool IsFinished() const
+	{
+		return bIsFinished;
+	}
+
+	// Fires the bursts due this frame, round-robin between the shooters
+	virtual void Tick(float DeltaTime) override
+	{
+		if (bIsFinished || !World.IsValid())
+		{
+			return;
+		}
+		PendingBursts += DeltaTime * Settings.BurstsPerSecond;
+		while ((PendingBursts >= 1.f) && (Shooters.Num() > 0))
+		{
+			PendingBursts -= 1.f;
+			UProjectileShooterComponent* const Shooter = Shooters[NextShooterIndex].Get();
+			NextShooterIndex = (NextShooterIndex + 1) % Shooters.Num();
+			++NumBursts;
+			NumRequestedShots += Settings.BurstSize;
+			/** The ammo is topped up before every burst, so that the shooters never run out of it. Bursts can still be refused
+				or cut short, e.g. when the projectile pool has no room, so the shots fired are counted from the ammo spent */
+			bool bHasShot = false;
+			if (Shooter != nullptr)
+			{
+				Shooter->Reload(Shooter->MaximumAmmo);
+				const int32 AmmoBeforeBurst = Shooter->GetCurrentAmmo();
+				bHasShot = Shooter->ShootBurst(Settings.BurstSize, EProjectileSpreadPattern::Fan);
+				NumFiredShots += AmmoBeforeBurst - Shooter->GetCurrentAmmo();
+			}
+			if (!bHasShot)
+			{
+				++NumRejectedBursts;
+			}
+		}
+	}
+
+	virtual bool IsTickable() const override
+	{
+		return !bIsFinished;
+	}
+
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FHordeStressTest, STATGROUP_Tickables);
+	}
+
+private:
+	// Spawns the shooters in a line, the objectives in a grid in front of them and the AI around the objectives
+	void SpawnHorde()
+	{
+		UWorld* const CurrentWorld = World.Get();
+		const APawn* const PlayerPawn = UGameplayStatics::GetPlayerPawn(CurrentWorld, 0);
+		const FVector Center = (PlayerPawn != nullptr) ? PlayerPawn->GetActorLocation() : FVector::ZeroVector;
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		// The shooters are characters of the same class as the player, so that they shoot with the same settings
+		UClass* ShooterClass = ABerlinByTestCharacter::StaticClass();
+		if ((PlayerPawn != nullptr) && PlayerPawn->IsA<ABerlinByTestCharacter>())
+		{
+			ShooterClass = PlayerPawn->GetClass();
+		}
+		for (int32 ShooterIndex = 0; ShooterIndex < Settings.NumShooters; ++ShooterIndex)
+		{
+			// Each shooter faces somewhere towards the objectives, so that their auto-aim doesn't pick the same candidates
+			const FVector Location = Center + FVector(-1500.f, (ShooterIndex - Settings.NumShooters * 0.5f) * 200.f, 0.f);
+			const FRotator Rotation(0.f, RandomStream.FRandRange(-90.f, 90.f), 0.f);
+			ABerlinByTestCharacter* const ShooterCharacter = CurrentWorld->SpawnActor<ABerlinByTestCharacter>(ShooterClass, Location, Rotation, SpawnParameters);
+			UProjectileShooterComponent* const Shooter = ShooterCharacter->IsValidLowLevel() ? ShooterCharacter->GetProjectileShooterComponent() : nullptr;
+			if (Shooter != nullptr)
+			{
+				// Without a controller, the control rotation would look along the X axis no matter where the pawn faces
+				if (ShooterCharacter->GetController() == nullptr)
+				{
+					ShooterCharacter->SpawnDefaultController();
+				}
+				// The bursts are only limited by the rate of the test, as the ammo is topped up before each one of them
+				Shooter->MinimumSecondsBetweenShots = 0.f;
+				Shooter->MaximumAmmo = FMath::Max(Shooter->MaximumAmmo, FMath::Min<int32>(Settings.BurstSize, MAX_uint8));
+				SpawnedActors.Add(ShooterCharacter);
+				Shooters.Add(Shooter);
+			}
+		}
+
+		UStaticMesh* const CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		const int32 GridSide = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Settings.NumObjectives))), 1);
+		const float Spacing = 200.f;
+		for (int32 ObjectiveIndex = 0; ObjectiveIndex < Settings.NumObjectives; ++ObjectiveIndex)
+		{
+			const FVector Location = Center + FVector(500.f + (ObjectiveIndex / GridSide) * Spacing, ((ObjectiveIndex % GridSide) - GridSide * 0.5f) * Spacing, 0.f);
+			AProjectileObjective* const Objective = CurrentWorld->SpawnActor<AProjectileObjective>(AProjectileObjective::StaticClass(), Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Objective->IsValidLowLevel())
+			{
+				// The objectives need collision for the projectiles and occlusion traces to hit them
+				if (CubeMesh != nullptr)
+				{
+					Objective->MeshComponent->SetStaticMesh(CubeMesh);
+				}
+				Objective->SetAutoAimPriority(RandomStream.FRandRange(0.f, 10.f));
+				SpawnedActors.Add(Objective);
+				Objectives.Add(Objective);
+			}
+		}
+
+		UClass* const AIClass = LoadClass<APawn>(nullptr, TEXT("/Game/AI/BP_AICharacter.BP_AICharacter_C"));
+		if (AIClass == nullptr)
+		{
+			UE_LOG(LogHordeStressTest, Error, TEXT("The AI character class couldn't be loaded, so the horde won't have any AI"));
+			return;
+		}
+		const float HordeRadius = FMath::Max(GridSide * Spacing, 2000.f);
+		for (int32 AIIndex = 0; AIIndex < Settings.NumAI; ++AIIndex)
+		{
+			const FVector2D Offset = FVector2D(RandomStream.FRandRange(-1.f, 1.f), RandomStream.FRandRange(-1.f, 1.f)) * HordeRadius;
+			const FVector Location = Center + FVector(500.f + Offset.X, Offset.Y, 100.f);
+			APawn* const AIPawn = CurrentWorld->SpawnActor<APawn>(AIClass, Location, FRotator(0.f, RandomStream.FRandRange(-180.f, 180.f), 0.f), SpawnParameters);
+			if (AIPawn->IsValidLowLevel())
+			{
+				// Pawns spawned at runtime only get their AI controller if their class asks for it
+				if (AIPawn->GetController() == nullptr)
+				{
+					AIPawn->SpawnDefaultController();
+				}
+				SpawnedActors.Add(AIPawn);
+				AI.Add(AIPawn);
+			}
+		}
+	}
+
+	void OnBeginFrame()
+	{
+		BeginFrameTimeInSeconds = FPlatformTime::Seconds();
+	}
+
+	// Writes the row of the frame, ending the test once its duration has passed
+	void OnEndFrame()
+	{
+		if (bIsFinished || (BeginFrameTimeInSeconds <= 0.0))
+		{
+			return;
+		}
+		// If the map changes or the game ends before the test does, the report of the frames run so far is still written
+		if (!World.IsValid())
+		{
+			Finish();
+			return;
+		}
+		const double NowInSeconds = FPlatformTime::Seconds();
+		const double ElapsedTimeInSeconds = NowInSeconds - StartTimeInSeconds;
+		// Without a frame rate limit, as when running headless, the game thread time is most of the frame
+		const double FrameTimeInMilliseconds = FApp::GetDeltaTime() * 1000.0;
+		const double GameThreadTimeInMilliseconds = (NowInSeconds - BeginFrameTimeInSeconds) * 1000.0;
+		const AProjectilePool* const ProjectilePool = AProjectilePool::Get(World.Get(), false);
+		const AProjectileSimulationManager* const SimulationManager = AProjectileSimulationManager::Get(World.Get(), false);
+		const int32 NumPooledProjectiles = ProjectilePool->IsValidLowLevel() ? ProjectilePool->GetNumActiveProjectiles() : 0;
+		const int32 NumSimulatedProjectiles = SimulationManager->IsValidLowLevel() ? SimulationManager->GetNumSimulatedProjectiles() : 0;
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		WriteReportLine(FString::Printf(TEXT("%d,%.3f,%.4f,%.4f,%d,%d,%d,%d,%d,%d,%d,%lld,%lld,%.2f,%.2f"), NumFrames, ElapsedTimeInSeconds, FrameTimeInMilliseconds, GameThreadTimeInMilliseconds,
+			World->GetActorCount(), CountValidActors(AI), CountValidActors(Objectives), NumPooledProjectiles, NumSimulatedProjectiles, NumBursts, NumRejectedBursts, NumRequestedShots, NumFiredShots,
+			MemoryStats.UsedPhysical / (1024.0 * 1024.0), MemoryStats.UsedVirtual / (1024.0 * 1024.0)));
+		++NumFrames;
+		// The first and last tenths of the run are compared, as they show whether the game degrades over time
+		const double TenthOfDurationInSeconds = Settings.DurationInSeconds * 0.1;
+		if (ElapsedTimeInSeconds < TenthOfDurationInSeconds)
+		{
+			FirstTenthGameThreadTime += GameThreadTimeInMilliseconds;
+			++NumFirstTenthFrames;
+		}
+		else if (ElapsedTimeInSeconds >= Settings.DurationInSeconds - TenthOfDurationInSeconds)
+		{
+			LastTenthGameThreadTime += GameThreadTimeInMilliseconds;
+			++NumLastTenthFrames;
+		}
+		if (ElapsedTimeInSeconds >= Settings.DurationInSeconds)
+		{
+			Finish();
+		}
+	}
+
+	// Closes the report, removes the horde and logs how much the frame time and memory grew during the run
+	void Finish()
+	{
+		bIsFinished = true;
+		ReportWriter->Close();
+		ReportWriter.Reset();
+		for (const TWeakObjectPtr<AActor>& SpawnedActor : SpawnedActors)
+		{
+			if (SpawnedActor.IsValid())
+			{
+				SpawnedActor->Destroy();
+			}
+		}
+		const double StartUsedPhysicalMegabytes = StartUsedPhysicalMemory / (1024.0 * 1024.0);
+		const double EndUsedPhysicalMegabytes = FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+		UE_LOG(LogHordeStressTest, Display, TEXT("Horde stress test ran %d frames and %d bursts (%d rejected), firing %lld of %lld requested shots"), NumFrames, NumBursts, NumRejectedBursts, NumFiredShots, NumRequestedShots);
+		UE_LOG(LogHordeStressTest, Display, TEXT("Game thread time: mean %.3f ms in the first tenth of the run, %.3f ms in the last one"), GetMean(FirstTenthGameThreadTime, NumFirstTenthFrames), GetMean(LastTenthGameThreadTime, NumLastTenthFrames));
+		UE_LOG(LogHordeStressTest, Display, TEXT("Used physical memory: %.1f MB at the start, %.1f MB at the end (%+.1f MB)"), StartUsedPhysicalMegabytes, EndUsedPhysicalMegabytes, EndUsedPhysicalMegabytes - StartUsedPhysicalMegabytes);
+		UE_LOG(LogHordeStressTest, Display, TEXT("Horde stress test report written to %s"), *ReportPath);
+		if (Settings.bShouldQuit)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+
+	void WriteReportLine(const FString& InLine)
+	{
+		const FTCHARToUTF8 Utf8Line(*(InLine + LINE_TERMINATOR));
+		ReportWriter->Serialize(const_cast<ANSICHAR*>(Utf8Line.Get()), Utf8Line.Length());
+	}
+
+	template<typename T>
+	static int32 CountValidActors(const TArray<TWeakObjectPtr<T>>& InActors)
+	{
+		int32 NumValidActors = 0;
+		for (const TWeakObjectPtr<T>& Actor : InActors)
+		{
+			if (Actor.IsValid() && !Actor->IsPendingKill())
+			{
+				++NumValidActors;
+			}
+		}
+		return NumValidActors;
+	}
+
+	static double GetMean(double InSum, int32 InNumSamples)
+	{
+		return InNumSamples > 0 ? InSum / InNumSamples : 0.0;
+	}
+
+	TWeakObjectPtr<UWorld> World;
+	FHordeStressTestSettings Settings;
+	FRandomStream RandomStream;
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+	TArray<TWeakObjectPtr<UProjectileShooterComponent>> Shooters;
+	TArray<TWeakObjectPtr<AProjectileObjective>> Objectives;
+	TArray<TWeakObjectPtr<APawn>> AI;
+	FString ReportPath;
+	TUniquePtr<FArchive> ReportWriter;
+	double StartTimeInSeconds;
+	double BeginFrameTimeInSeconds;
+	int32 NumFrames;
+	// Bursts due but not fired yet, as the fire rate doesn't need to be a multiple of the frame rate
+	float PendingBursts;
+	int32 NextShooterIndex;
+	int32 NumBursts;
+	int32 NumRejectedBursts;
+	// Projectiles asked for by the bursts and projectiles actually fired, which can be fewer when bursts are refused or cut short
+	int64 NumRequestedShots;
+	int64 NumFiredShots;
+	uint64 StartUsedPhysicalMemory;
+	// Game thread time (in milliseconds) of the first and last tenths of the run, summed so that memory doesn't grow with the run
+	double FirstTenthGameThreadTime;
+	int32 NumFirstTenthFrames;
+	double LastTenthGameThreadTime;
+	int32 NumLastTenthFrames;
+	FDelegateHandle BeginFrameHandle;
+	FDelegateHandle EndFrameHandle;
+	bool bIsFinished;
+};
+
+// Test currently running, only one at a time
+static TUniquePtr<FHordeStressTest> HordeStressTest;
+
+/** Usage: BerlinByTest.Benchmark.Horde [NumAI] [NumObjectives] [DurationInSeconds] [BurstsPerSecond] [NumShooters] [Quit]
+	If Quit is passed, the game exits once the test ends and its report has been written */
+static FAutoConsoleCommandWithWorldAndArgs HordeStressTestCommand(
+	TEXT("BerlinByTest.Benchmark.Horde"),
+	TEXT("Runs a horde of AI, objectives and shooters for a while, writing the time, actors, projectiles and memory of every frame. Usage: BerlinByTest.Benchmark.Horde [NumAI=200] [NumObjectives=1000] [DurationInSeconds=1800] [BurstsPerSecond=10] [NumShooters=8] [Quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld)
+	{
+		if ((InWorld == nullptr) || !InWorld->IsGameWorld())
+		{
+			UE_LOG(LogHordeStressTest, Error, TEXT("The horde stress test needs a game world to run"));
+			return;
+		}
+		if (HordeStressTest.IsValid() && !HordeStressTest->IsFinished())
+		{
+			UE_LOG(LogHordeStressTest, Error, TEXT("A horde stress test is already running"));
+			return;
+		}
+		FHordeStressTestSettings Settings;
+		int32 NumPositionalArgs = 0;
+		for (const FString& Arg : InArgs)
+		{
+			if (Arg.Equals(TEXT("Quit"), ESearchCase::IgnoreCase))
+			{
+				Settings.bShouldQuit = true;
+			}
+			else
+			{
+				switch (NumPositionalArgs++)
+				{
+				case 0:
+					Settings.NumAI = FMath::Max(FCString::Atoi(*Arg), 0);
+					break;
+				case 1:
+					Settings.NumObjectives = FMath::Max(FCString::Atoi(*Arg), 0);
+					break;
+				case 2:
+					Settings.DurationInSeconds = FMath::Max(FCString::Atof(*Arg), 1.f);
+					break;
+				case 3:
+					Settings.BurstsPerSecond = FMath::Max(FCString::Atof(*Arg), 0.f);
+					break;
+				case 4:
+					Settings.NumShooters = FMath::Max(FCString::Atoi(*Arg), 0);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+		HordeStressTest = MakeUnique<FHordeStressTest>(InWorld, Settings);
+		if (!HordeStressTest->Start())
+		{
+			HordeStressTest.Reset();
+			if (Settings.bShouldQuit)
+			{
+				FPlatformMisc::RequestExit(false);
+			}
+		}
+	})
+);
+
+#endif
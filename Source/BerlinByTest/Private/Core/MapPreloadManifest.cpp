@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Core/MapPreloadManifest.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+
+const FPrimaryAssetType UMapPreloadManifest::PrimaryAssetType = TEXT("MapPreloadManifest");
+
+FPrimaryAssetId UMapPreloadManifest::GetMapManifestId(const FString& InMapName)
+{
+	// Maps played in the editor have a prefix in their name, which the manifest doesn't have
+	const FString MapShortName = FPackageName::GetShortName(UWorld::RemovePIEPrefix(InMapName));
+	return FPrimaryAssetId(PrimaryAssetType, FName(*MapShortName));
+}
+
+FPrimaryAssetId UMapPreloadManifest::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+void UMapPreloadManifest::GetAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const
+{
+	for (const TSoftObjectPtr<UObject>& Asset : Assets)
+	{
+		if (!Asset.IsNull())
+		{
+			OutAssetPaths.AddUnique(Asset.ToSoftObjectPath());
+		}
+	}
+	for (const TSoftClassPtr<UObject>& Class : Classes)
+	{
+		if (!Class.IsNull())
+		{
+			OutAssetPaths.AddUnique(Class.ToSoftObjectPath());
+		}
+	}
+}
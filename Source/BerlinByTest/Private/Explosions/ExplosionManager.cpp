@@ -0,0 +1,331 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Explosions/ExplosionManager.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/DamageType.h"
+#include "Engine/EngineTypes.h"
+#include "Core/WorldSingleton.h"
+#include "Core/ScratchArray.h"
+#include "Projectiles/ProjectileHitDispatcher.h"
+
+DECLARE_CYCLE_STAT(TEXT("Explosions"), STAT_Explosions, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosion Traces"), STAT_ExplosionTraces, STATGROUP_BerlinByTest);
+
+// Sets default values
+AExplosionManager::AExplosionManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Explosions are applied once every actor has moved and queued its explosions for this frame
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+	TraceOriginMergeDistance = 25.f;
+	bUseAsyncTraces = false;
+}
+
+AExplosionManager* AExplosionManager::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AExplosionManager>(WorldContextObject, bCreateIfMissing);
+}
+
+void AExplosionManager::QueueExplosion(const UObject* WorldContextObject, const FVector& InOrigin, float InBaseDamage, float InDamageRadius, TSubclassOf<UDamageType> InDamageTypeClass, const TArray<AActor*>& InIgnoreActors, AActor* InDamageCauser, AController* InInstigatedBy, bool bInNotifyShootables, ECollisionChannel InDamagePreventionChannel)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	AExplosionManager* const ExplosionManager = Get(WorldContextObject);
+	if (ExplosionManager->IsValidLowLevel() && (InDamageRadius > 0.f))
+	{
+		FQueuedExplosion Explosion;
+		Explosion.Origin = InOrigin;
+		Explosion.BaseDamage = InBaseDamage;
+		Explosion.DamageRadius = InDamageRadius;
+		Explosion.DamageTypeClass = (InDamageTypeClass != nullptr) ? InDamageTypeClass : TSubclassOf<UDamageType>(UDamageType::StaticClass());
+		Explosion.DamageCauser = InDamageCauser;
+		Explosion.InstigatedBy = InInstigatedBy;
+		Explosion.bNotifyShootables = bInNotifyShootables;
+		Explosion.IgnoreActors.Append(InIgnoreActors);
+		Explosion.DamagePreventionChannel = InDamagePreventionChannel;
+		ExplosionManager->QueuedExplosions.Add(Explosion);
+	}
+}
+
+void AExplosionManager::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_Explosions);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, Explosions);
+	// The damage of the batches whose traces were requested in previous frames is applied first
+	int32 NumResolvedBatches = 0;
+	while ((NumResolvedBatches < PendingBatches.Num()) && (PendingBatches[NumResolvedBatches].TraceFrame < GFrameCounter))
+	{
+		ReadAsyncTraces(PendingBatches[NumResolvedBatches]);
+		ApplyDamage(PendingBatches[NumResolvedBatches]);
+		++NumResolvedBatches;
+	}
+	PendingBatches.RemoveAt(0, NumResolvedBatches);
+	if (QueuedExplosions.Num() > 0)
+	{
+		// The queue is emptied before applying any damage, as damaged actors might explode in response
+		FExplosionBatch Batch;
+		Batch.Explosions = MoveTemp(QueuedExplosions);
+		QueuedExplosions.Reset();
+		GatherVictims(Batch);
+		if (bUseAsyncTraces)
+		{
+			RequestAsyncTraces(Batch);
+			PendingBatches.Add(MoveTemp(Batch));
+		}
+		else
+		{
+			RunTraces(Batch);
+			ApplyDamage(Batch);
+		}
+	}
+}
+
+void AExplosionManager::GatherVictims(FExplosionBatch& InOutBatch) const
+{
+	UWorld* const CurrentWorld = GetWorld();
+	FMemMark ScratchMark(FMemStack::Get());
+	const int32 NumExplosions = InOutBatch.Explosions.Num();
+	// Explosions whose spheres overlap each other are grouped, so that each group only does a single overlap query
+	TScratchArray<int32> GroupIndices;
+	GroupIndices.SetNumUninitialized(NumExplosions);
+	for (int32 ExplosionIndex = 0; ExplosionIndex < NumExplosions; ++ExplosionIndex)
+	{
+		GroupIndices[ExplosionIndex] = ExplosionIndex;
+	}
+	auto FindGroup = [&GroupIndices](int32 InExplosionIndex)
+	{
+		while (GroupIndices[InExplosionIndex] != InExplosionIndex)
+		{
+			GroupIndices[InExplosionIndex] = GroupIndices[GroupIndices[InExplosionIndex]];
+			InExplosionIndex = GroupIndices[InExplosionIndex];
+		}
+		return InExplosionIndex;
+	};
+	for (int32 ExplosionIndex = 0; ExplosionIndex < NumExplosions; ++ExplosionIndex)
+	{
+		const FQueuedExplosion& Explosion = InOutBatch.Explosions[ExplosionIndex];
+		for (int32 OtherExplosionIndex = ExplosionIndex + 1; OtherExplosionIndex < NumExplosions; ++OtherExplosionIndex)
+		{
+			const FQueuedExplosion& OtherExplosion = InOutBatch.Explosions[OtherExplosionIndex];
+			if (FVector::DistSquared(Explosion.Origin, OtherExplosion.Origin) <= FMath::Square(Explosion.DamageRadius + OtherExplosion.DamageRadius))
+			{
+				GroupIndices[FindGroup(OtherExplosionIndex)] = FindGroup(ExplosionIndex);
+			}
+		}
+	}
+	TMap<int32, TScratchArray<int32>> ExplosionIndicesByGroup;
+	for (int32 ExplosionIndex = 0; ExplosionIndex < NumExplosions; ++ExplosionIndex)
+	{
+		ExplosionIndicesByGroup.FindOrAdd(FindGroup(ExplosionIndex)).Add(ExplosionIndex);
+	}
+
+	const float SafeMergeDistance = FMath::Max(TraceOriginMergeDistance, KINDA_SMALL_NUMBER);
+	TScratchArray<int32> TraceParamsIndices;
+	TraceParamsIndices.SetNumUninitialized(NumExplosions);
+	for (int32 ExplosionIndex = 0; ExplosionIndex < NumExplosions; ++ExplosionIndex)
+	{
+		TraceParamsIndices[ExplosionIndex] = FindOrAddTraceParams(InOutBatch, InOutBatch.Explosions[ExplosionIndex]);
+	}
+	TMap<TTuple<FIntVector, const UPrimitiveComponent*, int32>, int32> TraceIndicesByKey;
+	const FCollisionObjectQueryParams ObjectQueryParams(FCollisionObjectQueryParams::InitType::AllDynamicObjects);
+	const FCollisionQueryParams OverlapQueryParams(SCENE_QUERY_STAT(ExplosionOverlap), false);
+	// The overlap query needs a heap array, which is reused by every group instead
+	TArray<FOverlapResult> Overlaps;
+	for (const TPair<int32, TScratchArray<int32>>& Group : ExplosionIndicesByGroup)
+	{
+		// The overlap query covers the spheres of every explosion of the group
+		FVector GroupCenter = FVector::ZeroVector;
+		for (const int32 ExplosionIndex : Group.Value)
+		{
+			GroupCenter += InOutBatch.Explosions[ExplosionIndex].Origin;
+		}
+		GroupCenter /= Group.Value.Num();
+		float GroupRadius = 0.f;
+		for (const int32 ExplosionIndex : Group.Value)
+		{
+			const FQueuedExplosion& Explosion = InOutBatch.Explosions[ExplosionIndex];
+			GroupRadius = FMath::Max(GroupRadius, FVector::Dist(GroupCenter, Explosion.Origin) + Explosion.DamageRadius);
+		}
+		Overlaps.Reset();
+		CurrentWorld->OverlapMultiByObjectType(Overlaps, GroupCenter, FQuat::Identity, ObjectQueryParams, FCollisionShape::MakeSphere(GroupRadius), OverlapQueryParams);
+		// Each overlapped component is then checked against the sphere of every explosion of the group
+		for (const FOverlapResult& Overlap : Overlaps)
+		{
+			UPrimitiveComponent* const Component = Overlap.GetComponent();
+			const AActor* const OverlapActor = Overlap.GetActor();
+			if ((Component == nullptr) || (OverlapActor == nullptr) || !OverlapActor->bCanBeDamaged)
+			{
+				continue;
+			}
+			for (const int32 ExplosionIndex : Group.Value)
+			{
+				const FQueuedExplosion& Explosion = InOutBatch.Explosions[ExplosionIndex];
+				if ((OverlapActor == Explosion.DamageCauser.Get()) || Explosion.IgnoreActors.Contains(OverlapActor))
+				{
+					continue;
+				}
+				FVector ClosestPoint;
+				float DistanceToComponent = Component->GetDistanceToCollision(Explosion.Origin, ClosestPoint);
+				if (DistanceToComponent < 0.f)
+				{
+					// Components without simple collision are checked against their bounds instead
+					DistanceToComponent = FMath::Sqrt(Component->Bounds.GetBox().ComputeSquaredDistanceToPoint(Explosion.Origin));
+				}
+				if (DistanceToComponent <= Explosion.DamageRadius)
+				{
+					// Explosions at nearly the same origin with the same trace parameters share the trace to the component
+					const FVector QuantizedOrigin = Explosion.Origin / SafeMergeDistance;
+					const TTuple<FIntVector, const UPrimitiveComponent*, int32> TraceKey(FIntVector(FMath::RoundToInt(QuantizedOrigin.X), FMath::RoundToInt(QuantizedOrigin.Y), FMath::RoundToInt(QuantizedOrigin.Z)), Component, TraceParamsIndices[ExplosionIndex]);
+					int32* TraceIndex = TraceIndicesByKey.Find(TraceKey);
+					if (TraceIndex == nullptr)
+					{
+						FExplosionTrace Trace;
+						Trace.Start = Explosion.Origin;
+						Trace.End = Component->Bounds.Origin;
+						// Same nudge ApplyRadialDamage does, so that the trace has a direction
+						if (Trace.Start == Trace.End)
+						{
+							Trace.Start.Z += 0.01f;
+						}
+						Trace.Component = Component;
+						Trace.TraceParamsIndex = TraceParamsIndices[ExplosionIndex];
+						Trace.bIsVisible = false;
+						TraceIndex = &TraceIndicesByKey.Add(TraceKey, InOutBatch.Traces.Add(Trace));
+					}
+					FExplosionVictim Victim;
+					Victim.ExplosionIndex = ExplosionIndex;
+					Victim.TraceIndex = *TraceIndex;
+					InOutBatch.Victims.Add(Victim);
+				}
+			}
+		}
+	}
+}
+
+int32 AExplosionManager::FindOrAddTraceParams(FExplosionBatch& InOutBatch, const FQueuedExplosion& InExplosion)
+{
+	int32 TraceParamsIndex = InOutBatch.TraceParams.IndexOfByPredicate([&InExplosion](const FExplosionTraceParams& InTraceParams)
+	{
+		return (InTraceParams.Channel == InExplosion.DamagePreventionChannel) && (InTraceParams.DamageCauser == InExplosion.DamageCauser) && (InTraceParams.IgnoreActors == InExplosion.IgnoreActors);
+	});
+	if (TraceParamsIndex == INDEX_NONE)
+	{
+		// The damage causer and the ignored actors of the explosion don't block its damage, just like in ApplyRadialDamage
+		FExplosionTraceParams TraceParams;
+		TraceParams.Channel = InExplosion.DamagePreventionChannel;
+		TraceParams.DamageCauser = InExplosion.DamageCauser;
+		TraceParams.IgnoreActors = InExplosion.IgnoreActors;
+		TraceParams.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(ExplosionVisibility), true, InExplosion.DamageCauser.Get());
+		for (const TWeakObjectPtr<AActor>& IgnoredActor : InExplosion.IgnoreActors)
+		{
+			TraceParams.QueryParams.AddIgnoredActor(IgnoredActor.Get());
+		}
+		TraceParamsIndex = InOutBatch.TraceParams.Add(TraceParams);
+	}
+	return TraceParamsIndex;
+}
+
+void AExplosionManager::RunTraces(FExplosionBatch& InOutBatch) const
+{
+	UWorld* const CurrentWorld = GetWorld();
+	for (FExplosionTrace& Trace : InOutBatch.Traces)
+	{
+		const FExplosionTraceParams& TraceParams = InOutBatch.TraceParams[Trace.TraceParamsIndex];
+		FHitResult Hit;
+		const bool bHasHit = CurrentWorld->LineTraceSingleByChannel(Hit, Trace.Start, Trace.End, TraceParams.Channel, TraceParams.QueryParams);
+		SetTraceResult(Trace, bHasHit, Hit);
+	}
+	INC_DWORD_STAT_BY(STAT_ExplosionTraces, InOutBatch.Traces.Num());
+}
+
+void AExplosionManager::RequestAsyncTraces(FExplosionBatch& InOutBatch) const
+{
+	UWorld* const CurrentWorld = GetWorld();
+	for (FExplosionTrace& Trace : InOutBatch.Traces)
+	{
+		const FExplosionTraceParams& TraceParams = InOutBatch.TraceParams[Trace.TraceParamsIndex];
+		Trace.TraceHandle = CurrentWorld->AsyncLineTraceByChannel(EAsyncTraceType::Single, Trace.Start, Trace.End, TraceParams.Channel, TraceParams.QueryParams);
+	}
+	InOutBatch.TraceFrame = GFrameCounter;
+	INC_DWORD_STAT_BY(STAT_ExplosionTraces, InOutBatch.Traces.Num());
+}
+
+void AExplosionManager::ReadAsyncTraces(FExplosionBatch& InOutBatch) const
+{
+	UWorld* const CurrentWorld = GetWorld();
+	for (FExplosionTrace& Trace : InOutBatch.Traces)
+	{
+		FTraceDatum TraceDatum;
+		if (CurrentWorld->QueryTraceData(Trace.TraceHandle, TraceDatum))
+		{
+			const bool bHasHit = (TraceDatum.OutHits.Num() > 0) && TraceDatum.OutHits[0].bBlockingHit;
+			SetTraceResult(Trace, bHasHit, bHasHit ? TraceDatum.OutHits[0] : FHitResult());
+		}
+	}
+}
+
+void AExplosionManager::SetTraceResult(FExplosionTrace& InOutTrace, bool bInHasHit, const FHitResult& InHit)
+{
+	UPrimitiveComponent* const Component = InOutTrace.Component.Get();
+	InOutTrace.bIsVisible = false;
+	if (Component != nullptr)
+	{
+		if (bInHasHit)
+		{
+			// The component can only be damaged if nothing else blocks the trace before it
+			InOutTrace.bIsVisible = (InHit.Component.Get() == Component);
+			InOutTrace.Hit = InHit;
+		}
+		else
+		{
+			// Nothing blocks the damage, so the component is considered to be hit at its center
+			const FVector HitLocation = Component->GetComponentLocation();
+			InOutTrace.bIsVisible = true;
+			InOutTrace.Hit = FHitResult(Component->GetOwner(), Component, HitLocation, (InOutTrace.Start - HitLocation).GetSafeNormal());
+		}
+	}
+}
+
+void AExplosionManager::ApplyDamage(const FExplosionBatch& InBatch) const
+{
+	// Hits are grouped by explosion and damaged actor, so that every actor takes the damage of each explosion once
+	TArray<TMap<AActor*, TArray<FHitResult>>> HitsByExplosion;
+	HitsByExplosion.SetNum(InBatch.Explosions.Num());
+	for (const FExplosionVictim& Victim : InBatch.Victims)
+	{
+		const FExplosionTrace& Trace = InBatch.Traces[Victim.TraceIndex];
+		const UPrimitiveComponent* const Component = Trace.Component.Get();
+		if (Trace.bIsVisible && (Component != nullptr) && (Component->GetOwner() != nullptr))
+		{
+			HitsByExplosion[Victim.ExplosionIndex].FindOrAdd(Component->GetOwner()).Add(Trace.Hit);
+		}
+	}
+	for (int32 ExplosionIndex = 0; ExplosionIndex < InBatch.Explosions.Num(); ++ExplosionIndex)
+	{
+		const FQueuedExplosion& Explosion = InBatch.Explosions[ExplosionIndex];
+		FRadialDamageEvent DamageEvent;
+		DamageEvent.DamageTypeClass = Explosion.DamageTypeClass;
+		DamageEvent.Origin = Explosion.Origin;
+		// Full damage in the whole radius, just like ApplyRadialDamage
+		DamageEvent.Params = FRadialDamageParams(Explosion.BaseDamage, 0.f, Explosion.DamageRadius, Explosion.DamageRadius, 1.f);
+		for (TPair<AActor*, TArray<FHitResult>>& ActorHits : HitsByExplosion[ExplosionIndex])
+		{
+			AActor* const DamagedActor = ActorHits.Key;
+			if (DamagedActor->IsValidLowLevel() && !DamagedActor->IsPendingKill())
+			{
+				// Shootables are notified along with the rest of the hits of this frame, as they might queue new explosions in response
+				if (Explosion.bNotifyShootables)
+				{
+					const FHitResult& FirstHit = ActorHits.Value[0];
+					AProjectileHitDispatcher::QueueHit(this, Explosion.DamageCauser.Get(), DamagedActor, FirstHit.ImpactPoint, FirstHit.ImpactNormal);
+				}
+				DamageEvent.ComponentHits = MoveTemp(ActorHits.Value);
+				DamagedActor->TakeDamage(Explosion.BaseDamage, DamageEvent, Explosion.InstigatedBy.Get(), Explosion.DamageCauser.Get());
+			}
+		}
+	}
+}
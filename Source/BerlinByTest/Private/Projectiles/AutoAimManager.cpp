@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Projectiles/AutoAimManager.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Core/WorldSingleton.h"
+#include "Core/ScratchArray.h"
+#include "Projectiles/ProjectileShooterComponent.h"
+#include "Shootables/ShootableRegistry.h"
+
+DECLARE_CYCLE_STAT(TEXT("Parallel Auto-Aim"), STAT_ParallelAutoAim, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Snapshot Shootables"), STAT_SnapshotShootables, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Parallel Auto-Aim Shooters"), STAT_ParallelAutoAimShooters, STATGROUP_BerlinByTest);
+
+// Sets default values
+AAutoAimManager::AAutoAimManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Targets are traced before physics are simulated, so that the physics scene is not modified meanwhile
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	bUseParallelEvaluation = true;
+	MinimumShootersForParallelEvaluation = 4;
+}
+
+AAutoAimManager* AAutoAimManager::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AAutoAimManager>(WorldContextObject, bCreateIfMissing);
+}
+
+void AAutoAimManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Shooters.Empty();
+	Requests.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AAutoAimManager::RegisterShooter(UProjectileShooterComponent* InShooter)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	if (InShooter != nullptr)
+	{
+		Shooters.AddUnique(InShooter);
+	}
+}
+
+void AAutoAimManager::UnregisterShooter(UProjectileShooterComponent* InShooter)
+{
+	Shooters.Remove(InShooter);
+}
+
+void AAutoAimManager::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	Super::Tick(DeltaSeconds);
+	SCOPE_CYCLE_COUNTER(STAT_ParallelAutoAim);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, ParallelAutoAim);
+	// Only the shooters that could shoot this frame look for a target
+	Requests.Reset();
+	for (int32 ShooterIndex = Shooters.Num() - 1; ShooterIndex >= 0; --ShooterIndex)
+	{
+		UProjectileShooterComponent* const Shooter = Shooters[ShooterIndex].Get();
+		const AActor* const ShooterOwner = (Shooter != nullptr) ? Shooter->GetOwner() : nullptr;
+		if (Shooter == nullptr)
+		{
+			Shooters.RemoveAtSwap(ShooterIndex);
+		}
+		else if ((ShooterOwner != nullptr) && Shooter->HasAmmo())
+		{
+			// Pawns aim where they are looking, and any other owner, e.g. a turret, where it is facing
+			const APawn* const ShooterPawn = Cast<APawn>(ShooterOwner);
+			const FVector OwnerLocation = ShooterOwner->GetActorLocation();
+			const FVector OwnerForwardVector = (ShooterPawn != nullptr) ? UKismetMathLibrary::GetForwardVector(ShooterPawn->GetControlRotation()).GetSafeNormal() : ShooterOwner->GetActorForwardVector();
+			FAutoAimRequest Request;
+			Request.Shooter = Shooter;
+			Request.ScoringParameters = FAutoAimScoringParameters::Make(OwnerLocation, OwnerForwardVector, Shooter->MaximumVisionAngle, Shooter->MaximumDistance, Shooter->PriorityWeight, Shooter->DistanceWeight, Shooter->FocusWeight);
+			Request.NumTraceableCandidates = (Shooter->MaximumOcclusionTracesPerShot > 0) ? Shooter->MaximumOcclusionTracesPerShot : MAX_int32;
+			Request.Target = nullptr;
+			Request.NumCandidates = 0;
+			Request.NumTraces = 0;
+			Requests.Add(Request);
+		}
+	}
+	const AShootableRegistry* const ShootableRegistry = AShootableRegistry::Get(this);
+	if ((Requests.Num() > 0) && ShootableRegistry->IsValidLowLevel())
+	{
+		/** The snapshots live on the memory stack of the game thread until every request has been evaluated,
+			and the workers only read them */
+		FMemMark ScratchMark(FMemStack::Get());
+		TScratchArray<FAutoAimCandidateBatch> ShootableSnapshots;
+		ShootableSnapshots.SetNum(Requests.Num());
+		{
+			/** The shootables in the grid cells around the angle of vision of each shooter are copied on the game thread
+				along with the priorities stored by the registry, so that the worker threads only read the copies and never
+				the actors themselves, and shootables far from every shooter are never copied */
+			SCOPE_CYCLE_COUNTER(STAT_SnapshotShootables);
+			for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+			{
+				const FAutoAimScoringParameters& ScoringParameters = Requests[RequestIndex].ScoringParameters;
+				FAutoAimCandidateBatch& ShootableSnapshot = ShootableSnapshots[RequestIndex];
+				ShootableRegistry->ForEachShootableNearCone(ScoringParameters.Origin, ScoringParameters.ForwardVector, ScoringParameters.CosineOfMaximumVisionAngle, ScoringParameters.MaximumDistance, [&ShootableSnapshot](AActor* InShootableActor, float InAutoAimPriority)
+				{
+					ShootableSnapshot.Add(InShootableActor, InShootableActor->GetActorLocation(), InAutoAimPriority);
+				});
+			}
+		}
+		const bool bEvaluateInParallel = bUseParallelEvaluation && (Requests.Num() >= MinimumShootersForParallelEvaluation);
+		ParallelFor(Requests.Num(), [this, &ShootableSnapshots](int32 InRequestIndex)
+		{
+			EvaluateRequest(ShootableSnapshots[InRequestIndex], Requests[InRequestIndex]);
+		}, !bEvaluateInParallel);
+		// The results are handed to the shooters back on the game thread
+		int32 NumCandidates = 0;
+		int32 NumTraces = 0;
+		for (const FAutoAimRequest& Request : Requests)
+		{
+			Request.Shooter->SetParallelAutoAimTarget(Request.Target);
+			NumCandidates += Request.NumCandidates;
+			NumTraces += Request.NumTraces;
+		}
+		INC_DWORD_STAT_BY(STAT_ParallelAutoAimShooters, Requests.Num());
+		INC_DWORD_STAT_BY(STAT_AutoAimCandidates, NumCandidates);
+		INC_DWORD_STAT_BY(STAT_AutoAimTraces, NumTraces);
+		CSV_CUSTOM_STAT(BerlinByTest, AutoAimCandidates, NumCandidates, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(BerlinByTest, AutoAimTraces, NumTraces, ECsvCustomStatOp::Accumulate);
+	}
+}
+
+void AAutoAimManager::EvaluateRequest(const FAutoAimCandidateBatch& InShootableSnapshot, FAutoAimRequest& InOutRequest) const
+{
+	// Every worker has its own memory stack, so the scratch arrays of each request are released as soon as it is evaluated
+	FMemMark ScratchMark(FMemStack::Get());
+	TScratchArray<float> Scores;
+	Scores.SetNumUninitialized(InShootableSnapshot.Num());
+	ScoreAutoAimCandidates(InOutRequest.ScoringParameters, InShootableSnapshot, Scores);
+	// Actors without a positive score are never auto-aimed, so there is no need to trace them
+	TScratchArray<int32> CandidateIndices;
+	for (int32 ShootableIndex = 0; ShootableIndex < Scores.Num(); ++ShootableIndex)
+	{
+		if (Scores[ShootableIndex] > 0.f)
+		{
+			CandidateIndices.Add(ShootableIndex);
+		}
+	}
+	// Ties keep the order of the snapshot, just like the candidates of the shooter
+	CandidateIndices.StableSort([&Scores](int32 A, int32 B) { return Scores[A] > Scores[B]; });
+	InOutRequest.NumCandidates = CandidateIndices.Num();
+	/** Candidates are traced from the highest to the lowest score until one is not occluded by any other actor.
+		Scene queries only read the physics scene, which is not modified until physics are simulated */
+	UWorld* const CurrentWorld = GetWorld();
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ParallelAutoAimTrace));
+	const int32 NumTraceableCandidates = FMath::Min(CandidateIndices.Num(), InOutRequest.NumTraceableCandidates);
+	for (int32 CandidateIndex = 0; (CandidateIndex < NumTraceableCandidates) && (InOutRequest.Target == nullptr); ++CandidateIndex)
+	{
+		const int32 ShootableIndex = CandidateIndices[CandidateIndex];
+		AActor* const CandidateActor = InShootableSnapshot.Actors[ShootableIndex];
+		FHitResult TraceHit;
+		CurrentWorld->LineTraceSingleByChannel(TraceHit, InOutRequest.ScoringParameters.Origin, InShootableSnapshot.GetLocation(ShootableIndex), ECC_GameTraceChannel2, QueryParams);
+		++InOutRequest.NumTraces;
+		if (TraceHit.GetActor() == CandidateActor)
+		{
+			InOutRequest.Target = CandidateActor;
+		}
+	}
+}
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Projectiles/AutoAimScoring.h"
+#include "Math/VectorRegister.h"
+#include "BerlinByTest.h"
+
+DECLARE_CYCLE_STAT(TEXT("Score Auto-Aim Candidates"), STAT_ScoreAutoAimCandidates, STATGROUP_BerlinByTest);
+
+FAutoAimScoringParameters FAutoAimScoringParameters::Make(const FVector& InOrigin, const FVector& InForwardVector, float InMaximumVisionAngle, float InMaximumDistance, float InPriorityWeight, float InDistanceWeight, float InFocusWeight)
+{
+	FAutoAimScoringParameters Parameters;
+	Parameters.Origin = InOrigin;
+	Parameters.ForwardVector = InForwardVector;
+	Parameters.CosineOfMaximumVisionAngle = FGenericPlatformMath::Cos(FMath::DegreesToRadians(InMaximumVisionAngle));
+	Parameters.MaximumDistance = InMaximumDistance;
+	Parameters.PriorityFactor = 0.f;
+	Parameters.FocusFactor = 0.f;
+	Parameters.DistanceFactor = 0.f;
+	float TotalPrioritySum = InPriorityWeight + InFocusWeight;
+	// Only take distance into account if there is a maximum distance
+	if (InMaximumDistance > 0.f)
+	{
+		TotalPrioritySum += InDistanceWeight;
+	}
+	/** Don't calculate any further if it's going to divide by 0 or a negative number,
+		as that messes up the calculations */
+	Parameters.bCanScore = (TotalPrioritySum > 0.f);
+	if (Parameters.bCanScore)
+	{
+		// Each term is divided by its maximum value, so that all of them are between 0 and their weight
+		Parameters.PriorityFactor = InPriorityWeight * 0.1f / TotalPrioritySum;
+		const float FocusRange = 1.f - Parameters.CosineOfMaximumVisionAngle;
+		if (FocusRange > 0.f)
+		{
+			Parameters.FocusFactor = InFocusWeight / (FocusRange * TotalPrioritySum);
+		}
+		if (InMaximumDistance > 0.f)
+		{
+			Parameters.DistanceFactor = InDistanceWeight / (InMaximumDistance * TotalPrioritySum);
+		}
+	}
+	return Parameters;
+}
+
+void FAutoAimCandidateBatch::Reserve(int32 InNumCandidates)
+{
+	Actors.Reserve(InNumCandidates);
+	LocationsX.Reserve(InNumCandidates);
+	LocationsY.Reserve(InNumCandidates);
+	LocationsZ.Reserve(InNumCandidates);
+	Priorities.Reserve(InNumCandidates);
+}
+
+void FAutoAimCandidateBatch::Add(AActor* InActor, const FVector& InLocation, float InPriority)
+{
+	Actors.Add(InActor);
+	LocationsX.Add(InLocation.X);
+	LocationsY.Add(InLocation.Y);
+	LocationsZ.Add(InLocation.Z);
+	Priorities.Add(InPriority);
+}
+
+void FAutoAimCandidateBatch::Reset()
+{
+	Actors.Reset();
+	LocationsX.Reset();
+	LocationsY.Reset();
+	LocationsZ.Reset();
+	Priorities.Reset();
+}
+
+int32 FAutoAimCandidateBatch::Num() const
+{
+	return Actors.Num();
+}
+
+FVector FAutoAimCandidateBatch::GetLocation(int32 InCandidateIndex) const
+{
+	return FVector(LocationsX[InCandidateIndex], LocationsY[InCandidateIndex], LocationsZ[InCandidateIndex]);
+}
+
+/** Scores the candidates with the terms that are known not to be zeroed out by the configuration, so that
+	no time is spent computing terms that won't change the score */
+template<bool bHasDistanceLimit, bool bScoreDistance, bool bScorePriority>
+static void ScoreAutoAimCandidatesKernel(const FAutoAimScoringParameters& InParameters, const FAutoAimCandidateBatch& InCandidates, float* OutScores)
+{
+	const int32 NumCandidates = InCandidates.Num();
+	const int32 NumVectorizedCandidates = NumCandidates & ~3;
+	const float* const LocationsX = InCandidates.LocationsX.GetData();
+	const float* const LocationsY = InCandidates.LocationsY.GetData();
+	const float* const LocationsZ = InCandidates.LocationsZ.GetData();
+	const float* const Priorities = InCandidates.Priorities.GetData();
+
+	const VectorRegister OriginX = VectorSetFloat1(InParameters.Origin.X);
+	const VectorRegister OriginY = VectorSetFloat1(InParameters.Origin.Y);
+	const VectorRegister OriginZ = VectorSetFloat1(InParameters.Origin.Z);
+	const VectorRegister ForwardX = VectorSetFloat1(InParameters.ForwardVector.X);
+	const VectorRegister ForwardY = VectorSetFloat1(InParameters.ForwardVector.Y);
+	const VectorRegister ForwardZ = VectorSetFloat1(InParameters.ForwardVector.Z);
+	const VectorRegister CosineOfMaximumVisionAngle = VectorSetFloat1(InParameters.CosineOfMaximumVisionAngle);
+	const VectorRegister MaximumDistance = VectorSetFloat1(InParameters.MaximumDistance);
+	const VectorRegister PriorityFactor = VectorSetFloat1(InParameters.PriorityFactor);
+	const VectorRegister FocusFactor = VectorSetFloat1(InParameters.FocusFactor);
+	const VectorRegister DistanceFactor = VectorSetFloat1(InParameters.DistanceFactor);
+	const VectorRegister MaximumPriority = VectorSetFloat1(10.f);
+	const VectorRegister MinimumSquaredDistance = VectorSetFloat1(SMALL_NUMBER);
+	const VectorRegister Zero = VectorZero();
+
+	for (int32 CandidateIndex = 0; CandidateIndex < NumVectorizedCandidates; CandidateIndex += 4)
+	{
+		const VectorRegister ToCandidateX = VectorSubtract(VectorLoad(LocationsX + CandidateIndex), OriginX);
+		const VectorRegister ToCandidateY = VectorSubtract(VectorLoad(LocationsY + CandidateIndex), OriginY);
+		const VectorRegister ToCandidateZ = VectorSubtract(VectorLoad(LocationsZ + CandidateIndex), OriginZ);
+		const VectorRegister SquaredDistance = VectorMultiplyAdd(ToCandidateX, ToCandidateX, VectorMultiplyAdd(ToCandidateY, ToCandidateY, VectorMultiply(ToCandidateZ, ToCandidateZ)));
+		const VectorRegister DotProduct = VectorMultiplyAdd(ToCandidateX, ForwardX, VectorMultiplyAdd(ToCandidateY, ForwardY, VectorMultiply(ToCandidateZ, ForwardZ)));
+		// Candidates at the same location as the origin have no direction, so their cosine is 0
+		const VectorRegister HasDirection = VectorCompareGT(SquaredDistance, MinimumSquaredDistance);
+		const VectorRegister InverseDistance = VectorReciprocalSqrtAccurate(SquaredDistance);
+		const VectorRegister Cosine = VectorSelect(HasDirection, VectorMultiply(DotProduct, InverseDistance), Zero);
+		VectorRegister IsEligible = VectorCompareGT(Cosine, CosineOfMaximumVisionAngle);
+		VectorRegister Score = VectorMultiply(VectorSubtract(Cosine, CosineOfMaximumVisionAngle), FocusFactor);
+		if (bHasDistanceLimit)
+		{
+			const VectorRegister Distance = VectorSelect(HasDirection, VectorMultiply(SquaredDistance, InverseDistance), Zero);
+			IsEligible = VectorBitwiseAnd(IsEligible, VectorCompareGT(MaximumDistance, Distance));
+			if (bScoreDistance)
+			{
+				Score = VectorMultiplyAdd(VectorSubtract(MaximumDistance, Distance), DistanceFactor, Score);
+			}
+		}
+		if (bScorePriority)
+		{
+			const VectorRegister Priority = VectorMin(VectorMax(VectorLoad(Priorities + CandidateIndex), Zero), MaximumPriority);
+			Score = VectorMultiplyAdd(Priority, PriorityFactor, Score);
+		}
+		VectorStore(VectorSelect(IsEligible, Score, Zero), OutScores + CandidateIndex);
+	}
+
+	// The candidates that don't fill a whole vector are scored one by one with the same formula
+	for (int32 CandidateIndex = NumVectorizedCandidates; CandidateIndex < NumCandidates; ++CandidateIndex)
+	{
+		const FVector ToCandidate = FVector(LocationsX[CandidateIndex], LocationsY[CandidateIndex], LocationsZ[CandidateIndex]) - InParameters.Origin;
+		const float SquaredDistance = ToCandidate.SizeSquared();
+		const bool bHasDirection = (SquaredDistance > SMALL_NUMBER);
+		const float InverseDistance = bHasDirection ? FMath::InvSqrt(SquaredDistance) : 0.f;
+		const float Cosine = FVector::DotProduct(ToCandidate, InParameters.ForwardVector) * InverseDistance;
+		bool bIsEligible = (Cosine > InParameters.CosineOfMaximumVisionAngle);
+		float Score = (Cosine - InParameters.CosineOfMaximumVisionAngle) * InParameters.FocusFactor;
+		if (bHasDistanceLimit)
+		{
+			const float Distance = SquaredDistance * InverseDistance;
+			bIsEligible = bIsEligible && (Distance < InParameters.MaximumDistance);
+			if (bScoreDistance)
+			{
+				Score += (InParameters.MaximumDistance - Distance) * InParameters.DistanceFactor;
+			}
+		}
+		if (bScorePriority)
+		{
+			Score += Priorities[CandidateIndex] * InParameters.PriorityFactor;
+		}
+		OutScores[CandidateIndex] = bIsEligible ? Score : 0.f;
+	}
+}
+
+void ScoreAutoAimCandidates(const FAutoAimScoringParameters& InParameters, const FAutoAimCandidateBatch& InCandidates, TArrayView<float> OutScores)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ScoreAutoAimCandidates);
+	check(OutScores.Num() == InCandidates.Num());
+	if (!InParameters.bCanScore)
+	{
+		FMemory::Memzero(OutScores.GetData(), OutScores.Num() * sizeof(float));
+	}
+	else
+	{
+		const bool bHasDistanceLimit = (InParameters.MaximumDistance > 0.f);
+		const bool bScoreDistance = bHasDistanceLimit && (InParameters.DistanceFactor != 0.f);
+		const bool bScorePriority = (InParameters.PriorityFactor != 0.f);
+		float* const Scores = OutScores.GetData();
+		if (bHasDistanceLimit)
+		{
+			if (bScoreDistance)
+			{
+				if (bScorePriority)
+				{
+					ScoreAutoAimCandidatesKernel<true, true, true>(InParameters, InCandidates, Scores);
+				}
+				else
+				{
+					ScoreAutoAimCandidatesKernel<true, true, false>(InParameters, InCandidates, Scores);
+				}
+			}
+			else if (bScorePriority)
+			{
+				ScoreAutoAimCandidatesKernel<true, false, true>(InParameters, InCandidates, Scores);
+			}
+			else
+			{
+				ScoreAutoAimCandidatesKernel<true, false, false>(InParameters, InCandidates, Scores);
+			}
+		}
+		else if (bScorePriority)
+		{
+			ScoreAutoAimCandidatesKernel<false, false, true>(InParameters, InCandidates, Scores);
+		}
+		else
+		{
+			ScoreAutoAimCandidatesKernel<false, false, false>(InParameters, InCandidates, Scores);
+		}
+	}
+}
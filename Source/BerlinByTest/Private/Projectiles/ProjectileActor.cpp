@@ -1,10 +1,14 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Projectiles/ProjectileActor.h"
+#include "BerlinByTest.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/StaticMeshComponent.h"
-#include "Shootables/Shootable.h"
+#include "Projectiles/ProjectileHitDispatcher.h"
+#include "Projectiles/ProjectilePool.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Hit"), STAT_ProjectileHit, STATGROUP_BerlinByTest);
 
 // Sets default values
 AProjectileActor::AProjectileActor()
@@ -27,21 +31,90 @@ AProjectileActor::AProjectileActor()
 	ProjectileMovementComponent->SetUpdatedComponent(CollisionComponent);
 	ProjectileMovementComponent->InitialSpeed = 1000.0f;
 	ProjectileMovementComponent->ProjectileGravityScale = 0.f;
+	OwningPool = nullptr;
+	PoolExpirationTime = 0.f;
+	ActivePoolIndex = INDEX_NONE;
+	// Every machine fires its own projectiles from the spawn events of the shooters, so they are never replicated
+	bReplicates = false;
 }
 
 // Called when the game starts or when spawned
 void AProjectileActor::BeginPlay()
 {
 	Super::BeginPlay();
+	INC_DWORD_STAT(STAT_ProjectileActors);
+	/** Projectiles prewarmed before the level starts playing only begin play afterwards, which applies the initial life span.
+		The pool takes care of the life span of its projectiles, so they must not destroy themselves while waiting in it */
+	if (OwningPool != nullptr)
+	{
+		SetLifeSpan(0.f);
+	}
+}
+
+void AProjectileActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT(STAT_ProjectileActors);
+	Super::EndPlay(EndPlayReason);
 }
 
 void AProjectileActor::BeginHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent, FVector NormalImpulse, const FHitResult& Hit)
 {
-	// Notify the other actor that it has been hit by a projectile
-	if (OtherActor->GetClass()->ImplementsInterface(UShootable::StaticClass()))
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileHit);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, ProjectileHit);
+	/** The other actor will be notified that it has been hit by a projectile once physics have been simulated.
+		The projectile might have been fired again by then, so the hit is credited to its owner, which is the shooter */
+	AProjectileHitDispatcher::QueueHit(this, GetOwner(), OtherActor, Hit.ImpactPoint, Hit.ImpactNormal);
+	// Destroy the projectile whenever it hits another actor, or return it to its pool if it came from one
+	if (OwningPool->IsValidLowLevel())
 	{
-		IShootable::Execute_ProjectileHit(OtherActor);
+		OwningPool->ReturnProjectile(this);
 	}
-	// Destroy the projectile whenever it hits another actor
-	Destroy();
+	else
+	{
+		Destroy();
+	}
+}
+
+void AProjectileActor::ActivateFromPool(AProjectilePool* InPool, const FVector& InLocation, const FRotator& InRotation, AActor* InShooter, float InExpirationTime)
+{
+	OwningPool = InPool;
+	PoolExpirationTime = InExpirationTime;
+	SetOwner(InShooter);
+	SetActorLocationAndRotation(InLocation, InRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	// The movement component lets go of the collision component whenever the projectile stops after a hit
+	ProjectileMovementComponent->SetUpdatedComponent(CollisionComponent);
+	ProjectileMovementComponent->Velocity = InRotation.Vector() * ProjectileMovementComponent->InitialSpeed;
+	ProjectileMovementComponent->UpdateComponentVelocity();
+	ProjectileMovementComponent->SetComponentTickEnabled(true);
+}
+
+void AProjectileActor::DeactivateInPool(AProjectilePool* InPool)
+{
+	OwningPool = InPool;
+	PoolExpirationTime = 0.f;
+	ActivePoolIndex = INDEX_NONE;
+	SetOwner(nullptr);
+	// The pool takes care of the life span of pooled projectiles, so they must not destroy themselves
+	SetLifeSpan(0.f);
+	ProjectileMovementComponent->StopMovementImmediately();
+	ProjectileMovementComponent->SetComponentTickEnabled(false);
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
+
+float AProjectileActor::GetPoolExpirationTime() const
+{
+	return PoolExpirationTime;
+}
+
+int32 AProjectileActor::GetActivePoolIndex() const
+{
+	return ActivePoolIndex;
+}
+
+void AProjectileActor::SetActivePoolIndex(int32 InActivePoolIndex)
+{
+	ActivePoolIndex = InActivePoolIndex;
 }
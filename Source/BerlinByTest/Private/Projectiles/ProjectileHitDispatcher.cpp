@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Projectiles/ProjectileHitDispatcher.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "Core/WorldSingleton.h"
+#include "Shootables/Shootable.h"
+
+DECLARE_CYCLE_STAT(TEXT("Dispatch Projectile Hits"), STAT_DispatchProjectileHits, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Hits"), STAT_ProjectileHits, STATGROUP_BerlinByTest);
+
+// Sets default values
+AProjectileHitDispatcher::AProjectileHitDispatcher()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Hits are dispatched once physics and the explosions of this frame have been simulated
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+}
+
+AProjectileHitDispatcher* AProjectileHitDispatcher::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AProjectileHitDispatcher>(WorldContextObject, bCreateIfMissing);
+}
+
+void AProjectileHitDispatcher::QueueHit(const UObject* WorldContextObject, AActor* InHitter, AActor* InTarget, const FVector& InLocation, const FVector& InNormal)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	AProjectileHitDispatcher* const HitDispatcher = Get(WorldContextObject);
+	if (HitDispatcher->IsValidLowLevel() && (InTarget != nullptr))
+	{
+		FProjectileHit Hit;
+		Hit.Hitter = InHitter;
+		Hit.Target = InTarget;
+		Hit.Location = InLocation;
+		Hit.Normal = InNormal;
+		Hit.bIsTargetShootable = false;
+		HitDispatcher->QueuedHits.Add(Hit);
+	}
+}
+
+bool AProjectileHitDispatcher::IsShootableClass(UClass* InClass)
+{
+	bool* bIsShootable = ShootableClasses.Find(InClass);
+	if (bIsShootable == nullptr)
+	{
+		bIsShootable = &ShootableClasses.Add(InClass, InClass->ImplementsInterface(UShootable::StaticClass()));
+	}
+	return *bIsShootable;
+}
+
+void AProjectileHitDispatcher::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	Super::Tick(DeltaSeconds);
+	if (QueuedHits.Num() == 0)
+	{
+		return;
+	}
+	SCOPE_CYCLE_COUNTER(STAT_DispatchProjectileHits);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, DispatchProjectileHits);
+	INC_DWORD_STAT_BY(STAT_ProjectileHits, QueuedHits.Num());
+	// The queue is emptied before dispatching, as hit actors might fire projectiles or explode in response
+	Exchange(DispatchedHits, QueuedHits);
+	QueuedHits.Reset();
+	TArray<FProjectileHit>& Hits = DispatchedHits;
+	// Clients only show the hits, as only the server confirms them to the shootables
+	const bool bCanConfirmHits = (GetNetMode() != NM_Client);
+	for (FProjectileHit& Hit : Hits)
+	{
+		AActor* const Target = Hit.Target.Get();
+		if ((Target != nullptr) && !Target->IsPendingKill())
+		{
+			Hit.bIsTargetShootable = IsShootableClass(Target->GetClass());
+			if (bCanConfirmHits && Hit.bIsTargetShootable)
+			{
+				IShootable::Execute_ProjectileHit(Target);
+			}
+		}
+	}
+	OnProjectileHitsDispatched.Broadcast(Hits);
+}
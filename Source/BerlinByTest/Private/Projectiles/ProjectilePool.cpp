@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Projectiles/ProjectilePool.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "Core/WorldSingleton.h"
+#include "Projectiles/ProjectileActor.h"
+
+// Sets default values
+AProjectilePool::AProjectilePool()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+AProjectilePool* AProjectilePool::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AProjectilePool>(WorldContextObject, bCreateIfMissing);
+}
+
+void AProjectilePool::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Buckets.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+FProjectilePoolBucket& AProjectilePool::GetBucket(TSubclassOf<AProjectileActor> InProjectileClass)
+{
+	FProjectilePoolBucket* Bucket = Buckets.Find(InProjectileClass);
+	if (Bucket == nullptr)
+	{
+		Bucket = &Buckets.Add(InProjectileClass);
+		Bucket->LifeSpanInSeconds = InProjectileClass->GetDefaultObject<AProjectileActor>()->InitialLifeSpan;
+	}
+	return *Bucket;
+}
+
+AProjectileActor* AProjectilePool::SpawnInactiveProjectile(TSubclassOf<AProjectileActor> InProjectileClass)
+{
+	AProjectileActor* NewProjectile = nullptr;
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		NewProjectile = CurrentWorld->SpawnActor<AProjectileActor>(InProjectileClass, GetActorLocation(), FRotator::ZeroRotator, SpawnParameters);
+		if (NewProjectile->IsValidLowLevel())
+		{
+			NewProjectile->DeactivateInPool(this);
+		}
+	}
+	return NewProjectile;
+}
+
+void AProjectilePool::RemoveActiveProjectile(FProjectilePoolBucket& InOutBucket, int32 InActiveIndex)
+{
+	InOutBucket.ActiveProjectiles.RemoveAtSwap(InActiveIndex, 1, false);
+	if (InOutBucket.ActiveProjectiles.IsValidIndex(InActiveIndex) && (InOutBucket.ActiveProjectiles[InActiveIndex] != nullptr))
+	{
+		InOutBucket.ActiveProjectiles[InActiveIndex]->SetActivePoolIndex(InActiveIndex);
+	}
+}
+
+void AProjectilePool::Prewarm(TSubclassOf<AProjectileActor> InProjectileClass, int32 InPoolSize)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	if (InProjectileClass != nullptr)
+	{
+		FProjectilePoolBucket& Bucket = GetBucket(InProjectileClass);
+		int32 NumMissingProjectiles = InPoolSize - Bucket.InactiveProjectiles.Num() - Bucket.ActiveProjectiles.Num();
+		for (; NumMissingProjectiles > 0; --NumMissingProjectiles)
+		{
+			AProjectileActor* const NewProjectile = SpawnInactiveProjectile(InProjectileClass);
+			if (NewProjectile->IsValidLowLevel())
+			{
+				Bucket.InactiveProjectiles.Add(NewProjectile);
+			}
+		}
+	}
+}
+
+AProjectileActor* AProjectilePool::FireProjectile(TSubclassOf<AProjectileActor> InProjectileClass, const FVector& InLocation, const FRotator& InRotation, AActor* InShooter, EProjectilePoolOverflowPolicy InOverflowPolicy)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	AProjectileActor* FiredProjectile = nullptr;
+	if (InProjectileClass != nullptr)
+	{
+		FProjectilePoolBucket& Bucket = GetBucket(InProjectileClass);
+		// Projectiles might have been destroyed from outside the pool, for example when their level was unloaded
+		while ((FiredProjectile == nullptr) && (Bucket.InactiveProjectiles.Num() > 0))
+		{
+			FiredProjectile = Bucket.InactiveProjectiles.Pop(false);
+			if ((FiredProjectile != nullptr) && FiredProjectile->IsPendingKill())
+			{
+				FiredProjectile = nullptr;
+			}
+		}
+		if (FiredProjectile == nullptr)
+		{
+			switch (InOverflowPolicy)
+			{
+			case EProjectilePoolOverflowPolicy::Grow:
+				FiredProjectile = SpawnInactiveProjectile(InProjectileClass);
+				break;
+			case EProjectilePoolOverflowPolicy::RecycleOldest:
+			{
+				// Every projectile of a class has the same life span, so the one that expires first has been flying for the longest time
+				int32 OldestActiveIndex = INDEX_NONE;
+				for (int32 ActiveIndex = 0; ActiveIndex < Bucket.ActiveProjectiles.Num(); ++ActiveIndex)
+				{
+					const AProjectileActor* const ActiveProjectile = Bucket.ActiveProjectiles[ActiveIndex];
+					if ((ActiveProjectile != nullptr) && !ActiveProjectile->IsPendingKill()
+						&& ((OldestActiveIndex == INDEX_NONE) || (ActiveProjectile->GetPoolExpirationTime() < Bucket.ActiveProjectiles[OldestActiveIndex]->GetPoolExpirationTime())))
+					{
+						OldestActiveIndex = ActiveIndex;
+					}
+				}
+				if (OldestActiveIndex != INDEX_NONE)
+				{
+					FiredProjectile = Bucket.ActiveProjectiles[OldestActiveIndex];
+					RemoveActiveProjectile(Bucket, OldestActiveIndex);
+				}
+				break;
+			}
+			case EProjectilePoolOverflowPolicy::Fail:
+			default:
+				break;
+			}
+		}
+		if (FiredProjectile != nullptr)
+		{
+			const float CurrentTime = GetWorld()->GetTimeSeconds();
+			const float ExpirationTime = (Bucket.LifeSpanInSeconds > 0.f) ? (CurrentTime + Bucket.LifeSpanInSeconds) : 0.f;
+			FiredProjectile->ActivateFromPool(this, InLocation, InRotation, InShooter, ExpirationTime);
+			FiredProjectile->SetActivePoolIndex(Bucket.ActiveProjectiles.Add(FiredProjectile));
+		}
+	}
+	return FiredProjectile;
+}
+
+void AProjectilePool::ReturnProjectile(AProjectileActor* InProjectile)
+{
+	if (InProjectile->IsValidLowLevel())
+	{
+		FProjectilePoolBucket* const Bucket = Buckets.Find(InProjectile->GetClass());
+		// Projectiles are only deactivated once, even if they hit several actors in the same frame
+		const int32 ActiveIndex = InProjectile->GetActivePoolIndex();
+		if ((Bucket != nullptr) && Bucket->ActiveProjectiles.IsValidIndex(ActiveIndex) && (Bucket->ActiveProjectiles[ActiveIndex] == InProjectile))
+		{
+			RemoveActiveProjectile(*Bucket, ActiveIndex);
+			InProjectile->DeactivateInPool(this);
+			Bucket->InactiveProjectiles.Add(InProjectile);
+		}
+	}
+}
+
+int32 AProjectilePool::GetNumActiveProjectiles() const
+{
+	int32 NumActiveProjectiles = 0;
+	for (const TPair<UClass*, FProjectilePoolBucket>& Bucket : Buckets)
+	{
+		NumActiveProjectiles += Bucket.Value.ActiveProjectiles.Num();
+	}
+	return NumActiveProjectiles;
+}
+
+void AProjectilePool::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	Super::Tick(DeltaSeconds);
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	for (TPair<UClass*, FProjectilePoolBucket>& Bucket : Buckets)
+	{
+		/** Active projectiles are not kept in the order they were fired, so every one of them is checked. They are visited
+			from the last one, so that the projectiles swapped into the place of the removed ones have already been checked */
+		TArray<AProjectileActor*>& ActiveProjectiles = Bucket.Value.ActiveProjectiles;
+		for (int32 ActiveIndex = ActiveProjectiles.Num() - 1; ActiveIndex >= 0; --ActiveIndex)
+		{
+			AProjectileActor* const ActiveProjectile = ActiveProjectiles[ActiveIndex];
+			if ((ActiveProjectile == nullptr) || ActiveProjectile->IsPendingKill())
+			{
+				RemoveActiveProjectile(Bucket.Value, ActiveIndex);
+			}
+			else
+			{
+				const float ExpirationTime = ActiveProjectile->GetPoolExpirationTime();
+				if ((ExpirationTime > 0.f) && (ExpirationTime <= CurrentTime))
+				{
+					RemoveActiveProjectile(Bucket.Value, ActiveIndex);
+					ActiveProjectile->DeactivateInPool(this);
+					Bucket.Value.InactiveProjectiles.Add(ActiveProjectile);
+				}
+			}
+		}
+	}
+	const int32 NumActiveProjectiles = GetNumActiveProjectiles();
+	SET_DWORD_STAT(STAT_PooledProjectilesInFlight, NumActiveProjectiles);
+	CSV_CUSTOM_STAT(BerlinByTest, PooledProjectilesInFlight, NumActiveProjectiles, ECsvCustomStatOp::Set);
+}
@@ -1,10 +1,47 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Projectiles/ProjectileShooterComponent.h"
+#include "BerlinByTest.h"
 #include "Engine/World.h"
-#include "Kismet/GameplayStatics.h"
-#include "Shootables/Shootable.h"
+#include "Engine/AssetManager.h"
+#include "Shootables/ShootableRegistry.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Projectiles/AutoAimManager.h"
+#include "Projectiles/AutoAimScoring.h"
+#include "Projectiles/ProjectileActor.h"
+#include "Projectiles/ProjectileHitDispatcher.h"
+#include "Projectiles/ProjectileSimulationManager.h"
+#include "Engine/NetConnection.h"
+#include "UObject/CoreNet.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Shoot"), STAT_Shoot, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Get Centered Shootable Actor"), STAT_GetCenteredShootableActor, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Get Auto-Aim Candidates"), STAT_GetAutoAimCandidates, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Get Auto-Aim Score"), STAT_GetAutoAimScore, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Auto-Aim Trace"), STAT_AutoAimTrace, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Hitscan Trace"), STAT_HitscanTrace, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Start Reload"), STAT_StartReload, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Reload"), STAT_Reload, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replicated Shots"), STAT_ReplicatedShots, STATGROUP_BerlinByTest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replicated Shot Bits"), STAT_ReplicatedShotBits, STATGROUP_BerlinByTest);
+
+// Returns true if the shot sequence number comes after the other one, taking into account that they wrap around
+static bool IsShotSequenceNewer(uint16 InShotSequence, uint16 InOtherShotSequence)
+{
+	return (static_cast<int16>(InShotSequence - InOtherShotSequence) > 0);
+}
+
+FReplicatedShooterAmmo::FReplicatedShooterAmmo()
+	: Ammo(0)
+	, ReloadStartTimeInSeconds(0.f)
+	, bIsRegeneratingAmmo(false)
+	, LastProcessedShotSequence(0)
+{
+}
 
 // Sets default values for this component's properties
 UProjectileShooterComponent::UProjectileShooterComponent()
@@ -17,24 +54,144 @@ UProjectileShooterComponent::UProjectileShooterComponent()
 	MaximumDistance = -1.f;
 	FocusWeight = 1.f;
 	MaximumVisionAngle = 30.f;
+	AutoAimOcclusionMode = EAutoAimOcclusionMode::Synchronous;
+	MaximumOcclusionTracesPerShot = 0;
+	bUseBatchAutoAimScoring = true;
+	bUseParallelAutoAim = false;
+	ParallelAutoAimFrame = 0;
+	bUseAutoAimTargetTracking = false;
+	bTrackAutoAimTargetEveryFrame = false;
+	NumAutoAimRunnersUp = 3;
+	AutoAimRefreshIntervalInSeconds = 0.25f;
+	AutoAimRefreshDistanceThreshold = 50.f;
+	AutoAimRefreshAngleThreshold = 2.f;
+	bHasTrackedAutoAimTargets = false;
+	LastAutoAimRefreshTime = 0.f;
+	LastAutoAimRefreshLocation = FVector::ZeroVector;
+	LastAutoAimRefreshForwardVector = FVector::ForwardVector;
+	ReloadStartTimeInSeconds = 0.f;
+	bIsRegeneratingAmmo = false;
+	AmmoRegenerationMode = EAmmoRegenerationMode::Timer;
+	ProjectileDeliveryMode = EProjectileDeliveryMode::PooledActor;
+	ProjectilePoolSize = 16;
+	ProjectilePoolOverflowPolicy = EProjectilePoolOverflowPolicy::Grow;
+	HitscanRange = 10000.f;
+	bDrawHitscanTracers = true;
+	MinimumSecondsBetweenShots = 0.f;
+	SpreadAngle = 10.f;
+	VolleySize = 3;
+	VolleySpreadPattern = EProjectileSpreadPattern::Fan;
+	NextShotTimeInSeconds = 0.f;
+	MaximumShotOriginError = 200.f;
+	MaximumShotFastForwardInSeconds = 0.5f;
+	FireRateToleranceInSeconds = 0.05f;
+	LastPredictedShotSequence = 0;
+	LastAcknowledgedShotSequence = 0;
+	LastProcessedShotSequence = 0;
+	// Only the ammo and the shots are replicated, the projectiles themselves are simulated by every machine
+	bReplicates = true;
+	// The component only ticks while tracking the auto-aim target or while there are shots waiting for their occlusion traces
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
 // Called when the game starts
 void UProjectileShooterComponent::BeginPlay()
 {
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
 	Super::BeginPlay();
-	CurrentAmmo = InitialAmmo;
+	SetCurrentAmmo(InitialAmmo);
 	// In case the player doesn't start with full ammo, we try to start a reload cooldown
 	StartReload();
+	UpdateComponentTickEnabled();
+	LoadProjectileClass();
+	if (bUseParallelAutoAim)
+	{
+		AAutoAimManager* const AutoAimManager = AAutoAimManager::Get(this);
+		if (AutoAimManager->IsValidLowLevel())
+		{
+			AutoAimManager->RegisterShooter(this);
+		}
+	}
+}
+
+void UProjectileShooterComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AAutoAimManager* const AutoAimManager = AAutoAimManager::Get(this, false);
+	if (AutoAimManager->IsValidLowLevel())
+	{
+		AutoAimManager->UnregisterShooter(this);
+	}
+	if (ProjectileClassHandle.IsValid())
+	{
+		ProjectileClassHandle->ReleaseHandle();
+		ProjectileClassHandle.Reset();
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UProjectileShooterComponent::LoadProjectileClass()
+{
+	if (SoftProjectileClass.IsNull() || (SoftProjectileClass.Get() != nullptr))
+	{
+		PrewarmProjectilePool();
+	}
+	else
+	{
+		// Every shooter with the same projectile class shares the same load, and the pool is prewarmed once it finishes
+		ProjectileClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(SoftProjectileClass.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &UProjectileShooterComponent::PrewarmProjectilePool));
+	}
+}
+
+void UProjectileShooterComponent::PrewarmProjectilePool()
+{
+	TSubclassOf<AProjectileActor> PooledProjectileClass = GetProjectileActorClass();
+	if ((ProjectileDeliveryMode == EProjectileDeliveryMode::PooledActor) && (PooledProjectileClass != nullptr))
+	{
+		AProjectilePool* const ProjectilePool = AProjectilePool::Get(this);
+		if (ProjectilePool->IsValidLowLevel())
+		{
+			ProjectilePool->Prewarm(PooledProjectileClass, ProjectilePoolSize);
+		}
+	}
+}
+
+void UProjectileShooterComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	// Only the owning client shows the ammo, and it predicts it while shooting
+	DOREPLIFETIME_CONDITION(UProjectileShooterComponent, ServerAmmo, COND_OwnerOnly);
+}
+
+void UProjectileShooterComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		ServerAmmo = GetServerAmmo();
+	}
 }
 
 void UProjectileShooterComponent::StartReload()
 {
+	SCOPE_CYCLE_COUNTER(STAT_StartReload);
 	// If the player doesn't have his ammo already full...
 	if (!HasMaximumAmmo())
 	{
 		// ... and if there is no reload cooldown currently running...
-		if (!ReloadTimerHandle.IsValid())
+		if (AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp)
+		{
+			// ... the time at which the cooldown starts is all that is needed to know when the ammo will be reloaded
+			UWorld* const CurrentWorld = GetWorld();
+			if (!bIsRegeneratingAmmo && CurrentWorld->IsValidLowLevel())
+			{
+				bIsRegeneratingAmmo = true;
+				ReloadStartTimeInSeconds = CurrentWorld->GetTimeSeconds();
+				OnReloadStarted.Broadcast(ReloadStartTimeInSeconds, ReloadCooldownInSeconds);
+				OnReloadStartedNative.Broadcast(ReloadStartTimeInSeconds, ReloadCooldownInSeconds);
+			}
+		}
+		else if (!ReloadTimerHandle.IsValid())
 		{
 			// ... a new reload cooldown is started
 			bool bIsTimerManagerValid;
@@ -44,8 +201,120 @@ void UProjectileShooterComponent::StartReload()
 				FTimerDelegate TimerDelegate;
 				TimerDelegate.BindUFunction(this, FName("Reload"), 1);
 				TimerManager.SetTimer(ReloadTimerHandle, TimerDelegate, ReloadCooldownInSeconds, false);
+				ReloadStartTimeInSeconds = GetWorld()->GetTimeSeconds();
+				OnReloadStarted.Broadcast(ReloadStartTimeInSeconds, ReloadCooldownInSeconds);
+				OnReloadStartedNative.Broadcast(ReloadStartTimeInSeconds, ReloadCooldownInSeconds);
+			}
+		}
+	}
+}
+
+void UProjectileShooterComponent::SetCurrentAmmo(int32 InCurrentAmmo)
+{
+	if (CurrentAmmo != InCurrentAmmo)
+	{
+		CurrentAmmo = InCurrentAmmo;
+		OnAmmoChanged.Broadcast(CurrentAmmo, MaximumAmmo);
+		OnAmmoChangedNative.Broadcast(CurrentAmmo, MaximumAmmo);
+	}
+}
+
+void UProjectileShooterComponent::SpendAmmo(int32 InAmountOfAmmoToSpend)
+{
+	SetCurrentAmmo(CurrentAmmo - InAmountOfAmmoToSpend);
+	// Try to start a new reload cooldown, since we have a free space for sure
+	StartReload();
+}
+
+void UProjectileShooterComponent::OnRep_ServerAmmo()
+{
+	ApplyServerAmmo(ServerAmmo);
+}
+
+void UProjectileShooterComponent::ApplyServerAmmo(const FReplicatedShooterAmmo& InServerAmmo)
+{
+	// The replicated ammo and the ammo sent back after a rejected shot may arrive out of order, so the older one is discarded
+	if (!IsShotSequenceNewer(LastAcknowledgedShotSequence, InServerAmmo.LastProcessedShotSequence))
+	{
+		LastAcknowledgedShotSequence = InServerAmmo.LastProcessedShotSequence;
+		// The ammo of the shots the server has processed is already spent in its ammo
+		int32 NumAcknowledgedShots = 0;
+		while ((NumAcknowledgedShots < PredictedShots.Num()) && !IsShotSequenceNewer(PredictedShots[NumAcknowledgedShots].Sequence, LastAcknowledgedShotSequence))
+		{
+			++NumAcknowledgedShots;
+		}
+		PredictedShots.RemoveAt(0, NumAcknowledgedShots);
+		int32 NumUnacknowledgedProjectiles = 0;
+		for (const FPredictedShot& PredictedShot : PredictedShots)
+		{
+			NumUnacknowledgedProjectiles += PredictedShot.NumProjectiles;
+		}
+		if (AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp)
+		{
+			// The ammo is regenerated from the same moment as on the server, converted to the world time of this machine
+			const UWorld* const CurrentWorld = GetWorld();
+			const float ServerTimeOffsetInSeconds = CurrentWorld->IsValidLowLevel() ? (GetServerWorldTimeSeconds() - CurrentWorld->GetTimeSeconds()) : 0.f;
+			ReloadStartTimeInSeconds = InServerAmmo.ReloadStartTimeInSeconds - ServerTimeOffsetInSeconds;
+			bIsRegeneratingAmmo = InServerAmmo.bIsRegeneratingAmmo;
+			if (bIsRegeneratingAmmo)
+			{
+				OnReloadStarted.Broadcast(ReloadStartTimeInSeconds, ReloadCooldownInSeconds);
+				OnReloadStartedNative.Broadcast(ReloadStartTimeInSeconds, ReloadCooldownInSeconds);
 			}
 		}
+		SetCurrentAmmo(FMath::Max(InServerAmmo.Ammo - NumUnacknowledgedProjectiles, 0));
+		// The server may have spent ammo the client didn't predict, in which case the client has to reload it as well
+		StartReload();
+	}
+}
+
+FReplicatedShooterAmmo UProjectileShooterComponent::GetServerAmmo() const
+{
+	// The world time of the server is the server time every machine knows
+	FReplicatedShooterAmmo ReplicatedAmmo;
+	ReplicatedAmmo.Ammo = CurrentAmmo;
+	ReplicatedAmmo.ReloadStartTimeInSeconds = ReloadStartTimeInSeconds;
+	ReplicatedAmmo.bIsRegeneratingAmmo = bIsRegeneratingAmmo;
+	ReplicatedAmmo.LastProcessedShotSequence = LastProcessedShotSequence;
+	return ReplicatedAmmo;
+}
+
+int32 UProjectileShooterComponent::GetRegeneratedAmmo(float& OutReloadStartTimeInSeconds) const
+{
+	int32 RegeneratedAmmo = CurrentAmmo;
+	OutReloadStartTimeInSeconds = ReloadStartTimeInSeconds;
+	const UWorld* const CurrentWorld = GetWorld();
+	if ((AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp) && bIsRegeneratingAmmo && CurrentWorld->IsValidLowLevel())
+	{
+		const int32 MissingAmmo = FMath::Max(MaximumAmmo - CurrentAmmo, 0);
+		int32 NumCompletedReloads = MissingAmmo;
+		if (ReloadCooldownInSeconds > 0.f)
+		{
+			// Every completed cooldown reloads a projectile and starts the next cooldown right when it ends
+			const float ElapsedTimeInSeconds = CurrentWorld->GetTimeSeconds() - ReloadStartTimeInSeconds;
+			NumCompletedReloads = FMath::Min(FMath::FloorToInt(ElapsedTimeInSeconds / ReloadCooldownInSeconds), MissingAmmo);
+		}
+		if (NumCompletedReloads > 0)
+		{
+			RegeneratedAmmo = CurrentAmmo + NumCompletedReloads;
+			OutReloadStartTimeInSeconds = ReloadStartTimeInSeconds + NumCompletedReloads * FMath::Max(ReloadCooldownInSeconds, 0.f);
+		}
+	}
+	return RegeneratedAmmo;
+}
+
+void UProjectileShooterComponent::UpdateRegeneratedAmmo()
+{
+	if (AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp)
+	{
+		float RegeneratedReloadStartTimeInSeconds;
+		const int32 RegeneratedAmmo = GetRegeneratedAmmo(RegeneratedReloadStartTimeInSeconds);
+		ReloadStartTimeInSeconds = RegeneratedReloadStartTimeInSeconds;
+		if (RegeneratedAmmo >= MaximumAmmo)
+		{
+			bIsRegeneratingAmmo = false;
+		}
+		SetCurrentAmmo(RegeneratedAmmo);
 	}
 }
 
@@ -59,58 +328,300 @@ FTimerManager& UProjectileShooterComponent::GetTimerManager(bool& bOutIsTimerMan
 
 const AActor* UProjectileShooterComponent::GetCenteredShootableActor() const
 {
+	SCOPE_CYCLE_COUNTER(STAT_GetCenteredShootableActor);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, GetCenteredShootableActor);
 	const AActor* CenteredShootableActor = nullptr;
+	FMemMark ScratchMark(FMemStack::Get());
+	FVector OwnerLocation;
+	TScratchArray<FAutoAimCandidate> Candidates;
+	if (GetAutoAimCandidates(OwnerLocation, Candidates))
+	{
+		/** Candidates are sorted by score, so the first one which is not occluded by any other actor is the best one,
+			and there is no need to trace the rest of them */
+		const int32 NumTraceableCandidates = GetNumTraceableCandidates(Candidates.Num());
+		for (int32 CandidateIndex = 0; CandidateIndex < NumTraceableCandidates; ++CandidateIndex)
+		{
+			const FAutoAimCandidate& Candidate = Candidates[CandidateIndex];
+			if (IsAutoAimCandidateVisible(OwnerLocation, Candidate.Actor.Get(), Candidate.Location))
+			{
+				CenteredShootableActor = Candidate.Actor.Get();
+				break;
+			}
+		}
+	}
+	return CenteredShootableActor;
+}
+
+bool UProjectileShooterComponent::GetAutoAimCandidates(FVector& OutOwnerLocation, TScratchArray<FAutoAimCandidate>& OutCandidates) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GetAutoAimCandidates);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, GetAutoAimCandidates);
+	bool bCanAutoAim = false;
+	OutCandidates.Reset();
 	const APawn* const ComponentOwner = Cast<APawn>(GetOwner());
-	if (ComponentOwner->IsValidLowLevel())
+	const AShootableRegistry* const ShootableRegistry = AShootableRegistry::Get(this);
+	if (ComponentOwner->IsValidLowLevel() && ShootableRegistry->IsValidLowLevel())
 	{
-		float CurrentMaximumAutoAimScore = 0.f;
+		bCanAutoAim = true;
 		float CosineOfMaximumVisionAngle = FGenericPlatformMath::Cos(FMath::DegreesToRadians(MaximumVisionAngle));
-		FVector OwnerLocation = ComponentOwner->GetActorLocation();
+		OutOwnerLocation = ComponentOwner->GetActorLocation();
 		FVector OwnerForwardVector = UKismetMathLibrary::GetForwardVector(ComponentOwner->GetControlRotation());
 		OwnerForwardVector.Normalize();
-		UWorld* const CurrentWorld = GetWorld();
-		//Get all actors that implement the shootable interface to see which one is auto-aimable
-		TArray<AActor*> ShootableActors;
-		UGameplayStatics::GetAllActorsWithInterface(this, UShootable::StaticClass(), ShootableActors);
-		for (AActor* ShootableActor : ShootableActors)
-		{
-			// Check that the actor is within the maximum distance range
-			FVector ShootableActorLocation = ShootableActor->GetActorLocation();
-			FVector VectorToShootable = ShootableActorLocation - OwnerLocation;
-			float DistanceToShootable = VectorToShootable.Size();
-			if ((MaximumDistance <= 0.f) || (DistanceToShootable < MaximumDistance))
-			{
-				// Check that the actor is within the selected angle of vision
-				VectorToShootable.Normalize();
-				float DotProductOfVectors = FVector::DotProduct(VectorToShootable, OwnerForwardVector);
-				if (DotProductOfVectors > CosineOfMaximumVisionAngle)
+		if (bUseBatchAutoAimScoring)
+		{
+			/** Every shootable in the grid cells around the angle of vision is scored four at a time, and the ones
+				outside the maximum distance or angle of vision get a score of 0.
+				The batch is allocated under the mark the caller took for the candidates */
+			FAutoAimCandidateBatch CandidateBatch;
+			ShootableRegistry->ForEachShootableNearCone(OutOwnerLocation, OwnerForwardVector, CosineOfMaximumVisionAngle, MaximumDistance, [&](AActor* InShootableActor, float InAutoAimPriority)
+			{
+				CandidateBatch.Add(InShootableActor, InShootableActor->GetActorLocation(), InAutoAimPriority);
+			});
+			const FAutoAimScoringParameters ScoringParameters = FAutoAimScoringParameters::Make(OutOwnerLocation, OwnerForwardVector, MaximumVisionAngle, MaximumDistance, PriorityWeight, DistanceWeight, FocusWeight);
+			TScratchArray<float> CandidateScores;
+			CandidateScores.SetNumUninitialized(CandidateBatch.Num());
+			ScoreAutoAimCandidates(ScoringParameters, CandidateBatch, CandidateScores);
+			for (int32 CandidateIndex = 0; CandidateIndex < CandidateBatch.Num(); ++CandidateIndex)
+			{
+				// Actors without a positive score are never auto-aimed, so there is no need to trace them
+				if (CandidateScores[CandidateIndex] > 0.f)
 				{
-					// Check that the actor does not have any other actor occluding it
-					FHitResult TraceHit;
-					CurrentWorld->LineTraceSingleByChannel(TraceHit, OwnerLocation, ShootableActorLocation, ECC_GameTraceChannel2);
-					if (TraceHit.GetActor() == ShootableActor)
+					FAutoAimCandidate Candidate;
+					Candidate.Actor = CandidateBatch.Actors[CandidateIndex];
+					Candidate.Location = CandidateBatch.GetLocation(CandidateIndex);
+					Candidate.Score = CandidateScores[CandidateIndex];
+					OutCandidates.Add(Candidate);
+				}
+			}
+		}
+		else
+		{
+			// Only the shootables within the maximum distance and angle of vision are auto-aimable
+			TScratchArray<FShootableQueryResult> ShootablesInVision;
+			ShootableRegistry->GetShootablesInCone(OutOwnerLocation, OwnerForwardVector, CosineOfMaximumVisionAngle, MaximumDistance, ShootablesInVision);
+			for (const FShootableQueryResult& ShootableInVision : ShootablesInVision)
+			{
+				float ShootableActorAutoAimScore = GetAutoAimScore(ShootableInVision.AutoAimPriority, ShootableInVision.Distance, ShootableInVision.CosineToForward, CosineOfMaximumVisionAngle);
+				// Actors without a positive score are never auto-aimed, so there is no need to trace them
+				if (ShootableActorAutoAimScore > 0.f)
+				{
+					FAutoAimCandidate Candidate;
+					Candidate.Actor = ShootableInVision.Actor;
+					Candidate.Location = ShootableInVision.Location;
+					Candidate.Score = ShootableActorAutoAimScore;
+					OutCandidates.Add(Candidate);
+				}
+			}
+		}
+		// Candidates with the same score keep the order they were gathered in, so ties are always broken the same way
+		OutCandidates.StableSort([](const FAutoAimCandidate& A, const FAutoAimCandidate& B) { return A.Score > B.Score; });
+		INC_DWORD_STAT_BY(STAT_AutoAimCandidates, OutCandidates.Num());
+		CSV_CUSTOM_STAT(BerlinByTest, AutoAimCandidates, OutCandidates.Num(), ECsvCustomStatOp::Accumulate);
+	}
+	return bCanAutoAim;
+}
+
+bool UProjectileShooterComponent::IsAutoAimCandidateVisible(const FVector& InOwnerLocation, const AActor* InCandidate, const FVector& InCandidateLocation) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_AutoAimTrace);
+	INC_DWORD_STAT(STAT_AutoAimTraces);
+	CSV_CUSTOM_STAT(BerlinByTest, AutoAimTraces, 1, ECsvCustomStatOp::Accumulate);
+	bool bIsVisible = false;
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		FHitResult TraceHit;
+		CurrentWorld->LineTraceSingleByChannel(TraceHit, InOwnerLocation, InCandidateLocation, ECC_GameTraceChannel2);
+		bIsVisible = (TraceHit.GetActor() == InCandidate);
+	}
+	return bIsVisible;
+}
+
+const AActor* UProjectileShooterComponent::ResolveAutoAimTarget()
+{
+	const AActor* AutoAimTarget = nullptr;
+	if (!bUseAutoAimTargetTracking)
+	{
+		AutoAimTarget = GetCenteredShootableActor();
+	}
+	else
+	{
+		if (ShouldRefreshTrackedTargets())
+		{
+			RefreshTrackedTargets();
+			// The refresh has just checked the visibility of the tracked target
+			AutoAimTarget = TrackedAutoAimTarget.Get();
+		}
+		else if (TrackedAutoAimTarget.IsValid() || (AutoAimRunnersUp.Num() > 0))
+		{
+			// The tracked target is rechecked first, and if it is not valid anymore the runners-up take its place in order
+			if (IsAutoAimTargetStillValid(TrackedAutoAimTarget.Get()))
+			{
+				AutoAimTarget = TrackedAutoAimTarget.Get();
+			}
+			else
+			{
+				TrackedAutoAimTarget = nullptr;
+				while ((AutoAimTarget == nullptr) && (AutoAimRunnersUp.Num() > 0))
+				{
+					AActor* const RunnerUp = AutoAimRunnersUp[0].Get();
+					AutoAimRunnersUp.RemoveAt(0);
+					if (IsAutoAimTargetStillValid(RunnerUp))
 					{
-						// Check if the auto-aim score of this actor is the current highest one
-						if (ShootableActor->GetClass()->ImplementsInterface(UShootable::StaticClass()))
-						{
-							float ShootablePriority = IShootable::Execute_GetAutoAimPriority(ShootableActor);
-							float ShootableActorAutoAimScore = GetAutoAimScore(ShootablePriority, DistanceToShootable, DotProductOfVectors, CosineOfMaximumVisionAngle);
-							if (ShootableActorAutoAimScore > CurrentMaximumAutoAimScore)
-							{
-								CenteredShootableActor = ShootableActor;
-								CurrentMaximumAutoAimScore = ShootableActorAutoAimScore;
-							}
-						}
+						TrackedAutoAimTarget = RunnerUp;
+						AutoAimTarget = RunnerUp;
 					}
 				}
+				// If none of the tracked actors is valid anymore, the situation has changed and every candidate is evaluated again
+				if (AutoAimTarget == nullptr)
+				{
+					RefreshTrackedTargets();
+					AutoAimTarget = TrackedAutoAimTarget.Get();
+				}
 			}
 		}
 	}
-	return CenteredShootableActor;
+	return AutoAimTarget;
+}
+
+bool UProjectileShooterComponent::ShouldRefreshTrackedTargets() const
+{
+	bool bShouldRefresh = true;
+	const APawn* const ComponentOwner = Cast<APawn>(GetOwner());
+	const UWorld* const CurrentWorld = GetWorld();
+	if (bHasTrackedAutoAimTargets && ComponentOwner->IsValidLowLevel() && CurrentWorld->IsValidLowLevel())
+	{
+		const bool bHasIntervalEnded = (CurrentWorld->GetTimeSeconds() - LastAutoAimRefreshTime) >= AutoAimRefreshIntervalInSeconds;
+		const bool bHasMoved = FVector::DistSquared(ComponentOwner->GetActorLocation(), LastAutoAimRefreshLocation) > FMath::Square(AutoAimRefreshDistanceThreshold);
+		const FVector OwnerForwardVector = UKismetMathLibrary::GetForwardVector(ComponentOwner->GetControlRotation());
+		const bool bHasTurned = FVector::DotProduct(OwnerForwardVector, LastAutoAimRefreshForwardVector) < FMath::Cos(FMath::DegreesToRadians(AutoAimRefreshAngleThreshold));
+		bShouldRefresh = bHasIntervalEnded || bHasMoved || bHasTurned;
+	}
+	return bShouldRefresh;
+}
+
+void UProjectileShooterComponent::RefreshTrackedTargets()
+{
+	TrackedAutoAimTarget = nullptr;
+	AutoAimRunnersUp.Reset();
+	bHasTrackedAutoAimTargets = true;
+	const APawn* const ComponentOwner = Cast<APawn>(GetOwner());
+	UWorld* const CurrentWorld = GetWorld();
+	FMemMark ScratchMark(FMemStack::Get());
+	FVector OwnerLocation;
+	TScratchArray<FAutoAimCandidate> Candidates;
+	if (CurrentWorld->IsValidLowLevel() && GetAutoAimCandidates(OwnerLocation, Candidates))
+	{
+		LastAutoAimRefreshTime = CurrentWorld->GetTimeSeconds();
+		LastAutoAimRefreshLocation = OwnerLocation;
+		LastAutoAimRefreshForwardVector = UKismetMathLibrary::GetForwardVector(ComponentOwner->GetControlRotation());
+		// The best visible candidate is tracked, just like when auto-aiming without tracking
+		const int32 NumTraceableCandidates = GetNumTraceableCandidates(Candidates.Num());
+		int32 CandidateIndex = 0;
+		for (; (CandidateIndex < NumTraceableCandidates) && !TrackedAutoAimTarget.IsValid(); ++CandidateIndex)
+		{
+			const FAutoAimCandidate& Candidate = Candidates[CandidateIndex];
+			if (IsAutoAimCandidateVisible(OwnerLocation, Candidate.Actor.Get(), Candidate.Location))
+			{
+				TrackedAutoAimTarget = Candidate.Actor;
+			}
+		}
+		// The next candidates are kept without tracing them, as they will only be traced if they are ever needed
+		for (; (CandidateIndex < Candidates.Num()) && (AutoAimRunnersUp.Num() < NumAutoAimRunnersUp); ++CandidateIndex)
+		{
+			AutoAimRunnersUp.Add(Candidates[CandidateIndex].Actor);
+		}
+	}
+}
+
+bool UProjectileShooterComponent::IsAutoAimTargetStillValid(const AActor* InTarget) const
+{
+	bool bIsValid = false;
+	const APawn* const ComponentOwner = Cast<APawn>(GetOwner());
+	UWorld* const CurrentWorld = GetWorld();
+	if ((InTarget != nullptr) && !InTarget->IsPendingKill() && ComponentOwner->IsValidLowLevel() && CurrentWorld->IsValidLowLevel())
+	{
+		// Check that the actor is still within the maximum distance range and the selected angle of vision
+		const FVector OwnerLocation = ComponentOwner->GetActorLocation();
+		const FVector TargetLocation = InTarget->GetActorLocation();
+		FVector VectorToTarget = TargetLocation - OwnerLocation;
+		const float DistanceToTarget = VectorToTarget.Size();
+		if ((MaximumDistance <= 0.f) || (DistanceToTarget < MaximumDistance))
+		{
+			VectorToTarget.Normalize();
+			FVector OwnerForwardVector = UKismetMathLibrary::GetForwardVector(ComponentOwner->GetControlRotation());
+			OwnerForwardVector.Normalize();
+			const float CosineOfMaximumVisionAngle = FGenericPlatformMath::Cos(FMath::DegreesToRadians(MaximumVisionAngle));
+			if (FVector::DotProduct(VectorToTarget, OwnerForwardVector) > CosineOfMaximumVisionAngle)
+			{
+				// Check that the actor does not have any other actor occluding it
+				bIsValid = IsAutoAimCandidateVisible(OwnerLocation, InTarget, TargetLocation);
+			}
+		}
+	}
+	return bIsValid;
+}
+
+AActor* UProjectileShooterComponent::GetTrackedAutoAimTarget() const
+{
+	return TrackedAutoAimTarget.Get();
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+const AActor* UProjectileShooterComponent::GetCenteredShootableActorForTesting() const
+{
+	return GetCenteredShootableActor();
+}
+
+int32 UProjectileShooterComponent::GetNumAutoAimCandidatesForTesting() const
+{
+	FMemMark ScratchMark(FMemStack::Get());
+	FVector OwnerLocation;
+	TScratchArray<FAutoAimCandidate> Candidates;
+	GetAutoAimCandidates(OwnerLocation, Candidates);
+	return Candidates.Num();
+}
+
+float UProjectileShooterComponent::GetAutoAimScoreForTesting(float InPriority, float InDistance, float InCosineOfVisionAngle, float InCosineOfMaximumVisionAngle) const
+{
+	return GetAutoAimScore(InPriority, InDistance, InCosineOfVisionAngle, InCosineOfMaximumVisionAngle);
+}
+#endif
+
+void UProjectileShooterComponent::SetParallelAutoAimTarget(AActor* InTarget)
+{
+	ParallelAutoAimTarget = InTarget;
+	ParallelAutoAimFrame = GFrameCounter;
+}
+
+const AActor* UProjectileShooterComponent::GetParallelAutoAimTarget() const
+{
+	// Shooting before the manager has ticked this frame uses the target of the previous frame
+	const AActor* AutoAimTarget = nullptr;
+	if ((ParallelAutoAimFrame > 0) && (ParallelAutoAimFrame + 1 >= GFrameCounter))
+	{
+		AutoAimTarget = ParallelAutoAimTarget.Get();
+	}
+	else
+	{
+		AutoAimTarget = GetCenteredShootableActor();
+	}
+	return AutoAimTarget;
+}
+
+int32 UProjectileShooterComponent::GetNumTraceableCandidates(int32 InNumCandidates) const
+{
+	int32 NumTraceableCandidates = InNumCandidates;
+	if ((MaximumOcclusionTracesPerShot > 0) && (NumTraceableCandidates > MaximumOcclusionTracesPerShot))
+	{
+		NumTraceableCandidates = MaximumOcclusionTracesPerShot;
+	}
+	return NumTraceableCandidates;
 }
 
 float UProjectileShooterComponent::GetAutoAimScore(float InPriority, float InDistance, float InCosineOfVisionAngle, float InCosineOfMaximumVisionAngle) const
 {
+	SCOPE_CYCLE_COUNTER(STAT_GetAutoAimScore);
 	float AutoAimScore = 0.f;
 	float DistanceFraction = 0.f;
 	float TotalPrioritySum = PriorityWeight + FocusWeight;
@@ -145,6 +656,42 @@ float UProjectileShooterComponent::GetAutoAimScore(float InPriority, float InDis
 
 bool UProjectileShooterComponent::Shoot()
 {
+	return ShootBurst(1, EProjectileSpreadPattern::Fan);
+}
+
+bool UProjectileShooterComponent::ShootVolley()
+{
+	return ShootBurst(VolleySize, VolleySpreadPattern);
+}
+
+float UProjectileShooterComponent::GetRemainingFireCooldownInSeconds() const
+{
+	float SecondsRemaining = 0.f;
+	const UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		SecondsRemaining = FMath::Max(NextShotTimeInSeconds - CurrentWorld->GetTimeSeconds(), 0.f);
+	}
+	return SecondsRemaining;
+}
+
+bool UProjectileShooterComponent::ShootBurst(int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	SCOPE_CYCLE_COUNTER(STAT_Shoot);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, Shoot);
+	// Clients only shoot with the shooters they own, the rest of them fire the projectiles sent by the server
+	if (GetOwnerRole() == ROLE_SimulatedProxy)
+	{
+		return false;
+	}
+	// Shooting faster than the fire rate allows does nothing, not even spending ammo
+	if (GetRemainingFireCooldownInSeconds() > 0.f)
+	{
+		return false;
+	}
+	// The ammo reloaded since the last shot is stored before spending any
+	UpdateRegeneratedAmmo();
 	bool bHasAmmo = HasAmmo();
 	if (bHasAmmo)
 	{
@@ -162,45 +709,441 @@ bool UProjectileShooterComponent::Shoot()
 					FRotator ProjectileRotation = ComponentOwner->GetControlRotation(); */
 				FRotator ProjectileRotation = { 0.f, ComponentOwner->GetControlRotation().Yaw, 0.f };
 				FVector ProjectileLocation = ComponentOwner->GetActorLocation();
-				// If an actor can be auto-aimed to, that data is used instead
-				const AActor* const CenteredShootableActor = GetCenteredShootableActor();
-				if (CenteredShootableActor->IsValidLowLevel())
+				// Every projectile costs an ammo, and a replicated shot can't hold more than 255 of them
+				const int32 NumProjectiles = FMath::Clamp(InNumProjectiles, 1, FMath::Min<int32>(CurrentAmmo, MAX_uint8));
+				// Random spreads come from a seed, so that the other machines can fire the same projectiles
+				const int32 SpreadSeed = ((InSpreadPattern == EProjectileSpreadPattern::RandomCone) && (NumProjectiles > 1)) ? (FMath::Rand() & MAX_uint16) : 0;
+				// Auto-aim is resolved once for the whole burst
+				int32 NumShotProjectiles = NumProjectiles;
+				if (bUseParallelAutoAim)
 				{
-					ProjectileRotation = UKismetMathLibrary::FindLookAtRotation(ProjectileLocation, CenteredShootableActor->GetActorLocation());
+					NumShotProjectiles = SpawnProjectiles(ProjectileLocation, ProjectileRotation, GetParallelAutoAimTarget(), NumProjectiles, InSpreadPattern, SpreadSeed);
+				}
+				else if (AutoAimOcclusionMode == EAutoAimOcclusionMode::Asynchronous)
+				{
+					// The projectiles will be spawned once it is known which actor should be auto-aimed
+					QueueAsyncAutoAimShot(ProjectileLocation, ProjectileRotation, NumProjectiles, InSpreadPattern, SpreadSeed);
+				}
+				else
+				{
+					NumShotProjectiles = SpawnProjectiles(ProjectileLocation, ProjectileRotation, ResolveAutoAimTarget(), NumProjectiles, InSpreadPattern, SpreadSeed);
+				}
+				// No ammo is spent for the projectiles the projectile pool had no room for
+				if (NumShotProjectiles > 0)
+				{
+					SpendAmmo(NumShotProjectiles);
+					NextShotTimeInSeconds = CurrentWorld->GetTimeSeconds() + MinimumSecondsBetweenShots;
 				}
-				CurrentWorld->SpawnActor<AActor>(ProjectileClass, ProjectileLocation, ProjectileRotation);
-				--CurrentAmmo;
-				// Try to start a new reload cooldown, since we have a free space for sure
-				StartReload();
 			}
 		}
 	}
 	return bHasAmmo;
 }
 
+int32 UProjectileShooterComponent::SpawnProjectiles(const FVector& InProjectileLocation, const FRotator& InProjectileRotation, const AActor* InAutoAimedActor, int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern, int32 InSpreadSeed)
+{
+	FRotator AimRotation = InProjectileRotation;
+	// If an actor can be auto-aimed to, that data is used instead
+	if (InAutoAimedActor->IsValidLowLevel())
+	{
+		AimRotation = UKismetMathLibrary::FindLookAtRotation(InProjectileLocation, InAutoAimedActor->GetActorLocation());
+	}
+	// The direction of every projectile is computed in a single pass, and all of them are brought into the world together
+	TArray<FRotator, TInlineAllocator<16>> ProjectileRotations;
+	GetSpreadRotations(AimRotation, InNumProjectiles, InSpreadPattern, InSpreadSeed, ProjectileRotations);
+	const int32 NumSpawnedProjectiles = DeliverProjectiles(InProjectileLocation, ProjectileRotations);
+	if (NumSpawnedProjectiles > 0)
+	{
+		// The whole burst is sent as a single event, from which the other machines compute the same directions
+		FProjectileSpawnEvent SpawnEvent(InProjectileLocation, AimRotation, GetServerWorldTimeSeconds(), const_cast<AActor*>(InAutoAimedActor));
+		SpawnEvent.BurstSize = static_cast<uint8>(ProjectileRotations.Num());
+		SpawnEvent.NumProjectiles = static_cast<uint8>(NumSpawnedProjectiles);
+		SpawnEvent.SpreadPattern = static_cast<uint8>(InSpreadPattern);
+		SpawnEvent.SpreadSeed = static_cast<uint16>(InSpreadSeed);
+		ReplicateShot(SpawnEvent);
+		for (int32 ProjectileIndex = 0; ProjectileIndex < NumSpawnedProjectiles; ++ProjectileIndex)
+		{
+			OnShotFiredNative.Broadcast(InProjectileLocation, ProjectileRotations[ProjectileIndex], InAutoAimedActor);
+		}
+	}
+	return NumSpawnedProjectiles;
+}
+
+int32 UProjectileShooterComponent::DeliverProjectiles(const FVector& InProjectileLocation, TArrayView<const FRotator> InProjectileRotations)
+{
+	int32 NumDeliveredProjectiles = 0;
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		// The delivery mode is resolved once for every projectile of the shot
+		TSubclassOf<AProjectileActor> ProjectileActorClass = GetProjectileActorClass();
+		AProjectilePool* const ProjectilePool = ((ProjectileDeliveryMode == EProjectileDeliveryMode::PooledActor) && (ProjectileActorClass != nullptr)) ? AProjectilePool::Get(this) : nullptr;
+		AProjectileSimulationManager* const SimulationManager = ((ProjectileDeliveryMode == EProjectileDeliveryMode::Simulated) && (ProjectileActorClass != nullptr)) ? AProjectileSimulationManager::Get(this) : nullptr;
+		const bool bIsHitscan = (ProjectileDeliveryMode == EProjectileDeliveryMode::Hitscan);
+		for (const FRotator& ProjectileRotation : InProjectileRotations)
+		{
+			bool bHasSpawnedProjectile = false;
+			if (bIsHitscan)
+			{
+				bHasSpawnedProjectile = TraceHitscanShot(InProjectileLocation, ProjectileRotation, ProjectileActorClass);
+			}
+			else if (ProjectilePool->IsValidLowLevel())
+			{
+				bHasSpawnedProjectile = (ProjectilePool->FireProjectile(ProjectileActorClass, InProjectileLocation, ProjectileRotation, GetOwner(), ProjectilePoolOverflowPolicy) != nullptr);
+			}
+			else if (SimulationManager->IsValidLowLevel())
+			{
+				bHasSpawnedProjectile = SimulationManager->FireProjectile(ProjectileActorClass, InProjectileLocation, ProjectileRotation, GetOwner());
+			}
+			else
+			{
+				// The owner of the shooter owns the projectile, so that its hits are credited to it
+				FActorSpawnParameters SpawnParameters;
+				SpawnParameters.Owner = GetOwner();
+				bHasSpawnedProjectile = (CurrentWorld->SpawnActor<AActor>(GetSpawnedProjectileClass(), InProjectileLocation, ProjectileRotation, SpawnParameters) != nullptr);
+			}
+			// The projectiles left wouldn't be brought into the world either, e.g. when the projectile pool has run out of them
+			if (!bHasSpawnedProjectile)
+			{
+				break;
+			}
+			++NumDeliveredProjectiles;
+		}
+	}
+	return NumDeliveredProjectiles;
+}
+
+bool UProjectileShooterComponent::TraceHitscanShot(const FVector& InProjectileLocation, const FRotator& InProjectileRotation, TSubclassOf<AProjectileActor> InProjectileActorClass)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitscanTrace);
+	bool bHasShot = false;
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		// The shot collides with the same things the projectiles of its class would, and it never hits its own owner
+		FName CollisionProfileName = TEXT("Projectile");
+		if (InProjectileActorClass != nullptr)
+		{
+			CollisionProfileName = InProjectileActorClass->GetDefaultObject<AProjectileActor>()->CollisionComponent->GetCollisionProfileName();
+		}
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitscanTrace), false, GetOwner());
+		const FVector EndLocation = InProjectileLocation + InProjectileRotation.Vector() * HitscanRange;
+		FHitResult TraceHit;
+		float TracerDistance = HitscanRange;
+		if (CurrentWorld->LineTraceSingleByProfile(TraceHit, InProjectileLocation, EndLocation, CollisionProfileName, QueryParams))
+		{
+			// Clients trace as well to draw their tracers, but only the server confirms the hits to the shootables
+			AProjectileHitDispatcher::QueueHit(this, GetOwner(), TraceHit.GetActor(), TraceHit.ImpactPoint, TraceHit.ImpactNormal);
+			TracerDistance = TraceHit.Distance;
+		}
+		if (bDrawHitscanTracers && (InProjectileActorClass != nullptr))
+		{
+			AProjectileSimulationManager* const SimulationManager = AProjectileSimulationManager::Get(this);
+			if (SimulationManager->IsValidLowLevel())
+			{
+				SimulationManager->FireTracer(InProjectileActorClass, InProjectileLocation, InProjectileRotation, TracerDistance);
+			}
+		}
+		bHasShot = true;
+	}
+	return bHasShot;
+}
+
+void UProjectileShooterComponent::GetSpreadRotations(const FRotator& InAimRotation, int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern, int32 InSpreadSeed, TArray<FRotator, TInlineAllocator<16>>& OutRotations) const
+{
+	OutRotations.Reset();
+	if ((InNumProjectiles <= 1) || (SpreadAngle <= 0.f))
+	{
+		// Without spread, every projectile flies straight where the shot is aimed
+		OutRotations.Init(InAimRotation, FMath::Max(InNumProjectiles, 1));
+	}
+	else
+	{
+		// The spread is computed around the forward axis and then turned towards where the shot is aimed
+		const FQuat AimQuaternion = InAimRotation.Quaternion();
+		FRandomStream SpreadStream(InSpreadSeed);
+		for (int32 ProjectileIndex = 0; ProjectileIndex < InNumProjectiles; ++ProjectileIndex)
+		{
+			FVector SpreadDirection = FVector::ForwardVector;
+			switch (InSpreadPattern)
+			{
+			case EProjectileSpreadPattern::Fan:
+				SpreadDirection = FRotator(0.f, FMath::Lerp(-SpreadAngle, SpreadAngle, ProjectileIndex / static_cast<float>(InNumProjectiles - 1)), 0.f).Vector();
+				break;
+			case EProjectileSpreadPattern::Ring:
+				if (ProjectileIndex > 0)
+				{
+					const float RingAngle = 2.f * PI * (ProjectileIndex - 1) / (InNumProjectiles - 1);
+					SpreadDirection = SpreadDirection.RotateAngleAxis(SpreadAngle, FVector(0.f, FMath::Cos(RingAngle), FMath::Sin(RingAngle)));
+				}
+				break;
+			case EProjectileSpreadPattern::RandomCone:
+			default:
+				SpreadDirection = SpreadStream.VRandCone(FVector::ForwardVector, FMath::DegreesToRadians(SpreadAngle));
+				break;
+			}
+			OutRotations.Add(AimQuaternion.RotateVector(SpreadDirection).Rotation());
+		}
+	}
+}
+
+void UProjectileShooterComponent::ReplicateShot(const FProjectileSpawnEvent& InSpawnEvent)
+{
+	const AActor* const ComponentOwner = GetOwner();
+	if (ComponentOwner->IsValidLowLevel() && GetIsReplicated() && (GetNetMode() != NM_Standalone))
+	{
+		if (GetOwnerRole() == ROLE_Authority)
+		{
+			MulticastProjectileSpawned(InSpawnEvent);
+		}
+		else if (GetOwnerRole() == ROLE_AutonomousProxy)
+		{
+			// The shot is numbered, so that the client knows whether the ammo sent by the server has already spent it
+			++LastPredictedShotSequence;
+			FPredictedShot PredictedShot;
+			PredictedShot.Sequence = LastPredictedShotSequence;
+			PredictedShot.NumProjectiles = InSpawnEvent.NumProjectiles;
+			PredictedShots.Add(PredictedShot);
+			ServerShoot(InSpawnEvent, LastPredictedShotSequence);
+		}
+#if STATS || CSV_PROFILER
+		// The event is written once more to measure it, which is only worth it while profiling
+		const UNetConnection* const NetConnection = ComponentOwner->GetNetConnection();
+		FNetBitWriter SpawnEventWriter((NetConnection != nullptr) ? NetConnection->PackageMap : nullptr, 256);
+		FProjectileSpawnEvent MeasuredSpawnEvent = InSpawnEvent;
+		bool bHasMeasured;
+		MeasuredSpawnEvent.NetSerialize(SpawnEventWriter, SpawnEventWriter.PackageMap, bHasMeasured);
+		const int32 NumSpawnEventBits = static_cast<int32>(SpawnEventWriter.GetNumBits());
+		INC_DWORD_STAT(STAT_ReplicatedShots);
+		INC_DWORD_STAT_BY(STAT_ReplicatedShotBits, NumSpawnEventBits);
+		CSV_CUSTOM_STAT(BerlinByTest, ReplicatedShots, 1, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(BerlinByTest, ReplicatedShotBits, NumSpawnEventBits, ECsvCustomStatOp::Accumulate);
+#endif
+	}
+}
+
+bool UProjectileShooterComponent::ServerShoot_Validate(const FProjectileSpawnEvent& InSpawnEvent, uint16 InShotSequence)
+{
+	return !InSpawnEvent.Origin.ContainsNaN() && (InSpawnEvent.NumProjectiles > 0) && (InSpawnEvent.NumProjectiles <= InSpawnEvent.BurstSize) && (InSpawnEvent.SpreadPattern <= static_cast<uint8>(EProjectileSpreadPattern::RandomCone));
+}
+
+void UProjectileShooterComponent::ServerShoot_Implementation(const FProjectileSpawnEvent& InSpawnEvent, uint16 InShotSequence)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	// Shots arrive in order, and the ammo sent to the client from now on includes this one whether it is fired or not
+	LastProcessedShotSequence = InShotSequence;
+	UpdateRegeneratedAmmo();
+	int32 NumShotProjectiles = 0;
+	const AActor* const ComponentOwner = GetOwner();
+	const UWorld* const CurrentWorld = GetWorld();
+	// The client chooses where to aim, but the server has the final say over the ammo, the fire rate and where the projectiles come from
+	if (HasAmmo() && ComponentOwner->IsValidLowLevel() && CurrentWorld->IsValidLowLevel() && (CurrentWorld->GetTimeSeconds() + FireRateToleranceInSeconds >= NextShotTimeInSeconds)
+		&& (FVector::DistSquared(InSpawnEvent.Origin, ComponentOwner->GetActorLocation()) <= FMath::Square(MaximumShotOriginError)))
+	{
+		// Only the projectiles the client fired and the server has ammo for are fired
+		TArray<FRotator, TInlineAllocator<16>> ProjectileRotations;
+		GetSpreadRotations(InSpawnEvent.GetRotation(), InSpawnEvent.BurstSize, static_cast<EProjectileSpreadPattern>(InSpawnEvent.SpreadPattern), InSpawnEvent.SpreadSeed, ProjectileRotations);
+		ProjectileRotations.SetNum(FMath::Min3<int32>(ProjectileRotations.Num(), InSpawnEvent.NumProjectiles, CurrentAmmo));
+		NumShotProjectiles = DeliverProjectiles(InSpawnEvent.Origin, ProjectileRotations);
+	}
+	if (NumShotProjectiles > 0)
+	{
+		SpendAmmo(NumShotProjectiles);
+		// Shots let in early by the tolerance don't move the next ones forward, so the fire rate can't be beaten over time
+		NextShotTimeInSeconds = FMath::Max(NextShotTimeInSeconds, CurrentWorld->GetTimeSeconds()) + MinimumSecondsBetweenShots;
+		// The other clients only simulate the projectiles the server has fired
+		FProjectileSpawnEvent ServerSpawnEvent = InSpawnEvent;
+		ServerSpawnEvent.ServerTimeInSeconds = GetServerWorldTimeSeconds();
+		ServerSpawnEvent.NumProjectiles = static_cast<uint8>(NumShotProjectiles);
+		ReplicateShot(ServerSpawnEvent);
+	}
+	// The client predicted every projectile of the burst, so it gets the ammo of the server back if any of them wasn't fired
+	if (NumShotProjectiles < InSpawnEvent.NumProjectiles)
+	{
+		ClientShotRejected(GetServerAmmo());
+	}
+}
+
+void UProjectileShooterComponent::ClientShotRejected_Implementation(const FReplicatedShooterAmmo& InServerAmmo)
+{
+	// The projectile predicted by the client keeps flying, but it can't hit anything as only the server confirms hits
+	ApplyServerAmmo(InServerAmmo);
+}
+
+void UProjectileShooterComponent::MulticastProjectileSpawned_Implementation(const FProjectileSpawnEvent& InSpawnEvent)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	// The server has already fired the projectiles, and so has the owning client when it predicted them
+	if (GetOwnerRole() == ROLE_SimulatedProxy)
+	{
+		// The spread is computed for the whole burst, but only the projectiles the server fired are simulated
+		TArray<FRotator, TInlineAllocator<16>> ProjectileRotations;
+		GetSpreadRotations(InSpawnEvent.GetRotation(), InSpawnEvent.BurstSize, static_cast<EProjectileSpreadPattern>(InSpawnEvent.SpreadPattern), InSpawnEvent.SpreadSeed, ProjectileRotations);
+		ProjectileRotations.SetNum(FMath::Min<int32>(ProjectileRotations.Num(), InSpawnEvent.NumProjectiles));
+		/** The projectiles are moved forward along their straight paths for as long as they have already been flying on the server.
+			Hitscan shots have no flight time, so they are traced from the origin */
+		float FastForwardDistance = 0.f;
+		TSubclassOf<AProjectileActor> ProjectileActorClass = GetProjectileActorClass();
+		if ((ProjectileActorClass != nullptr) && (ProjectileDeliveryMode != EProjectileDeliveryMode::Hitscan))
+		{
+			const AProjectileActor* const DefaultProjectile = ProjectileActorClass->GetDefaultObject<AProjectileActor>();
+			const float FlightTimeInSeconds = FMath::Clamp(GetServerWorldTimeSeconds() - InSpawnEvent.ServerTimeInSeconds, 0.f, MaximumShotFastForwardInSeconds);
+			FastForwardDistance = DefaultProjectile->ProjectileMovementComponent->InitialSpeed * FlightTimeInSeconds;
+		}
+		for (const FRotator& ProjectileRotation : ProjectileRotations)
+		{
+			DeliverProjectiles(InSpawnEvent.Origin + ProjectileRotation.Vector() * FastForwardDistance, MakeArrayView(&ProjectileRotation, 1));
+		}
+	}
+}
+
+float UProjectileShooterComponent::GetServerWorldTimeSeconds() const
+{
+	float ServerWorldTimeSeconds = 0.f;
+	const UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		const AGameStateBase* const GameState = CurrentWorld->GetGameState();
+		ServerWorldTimeSeconds = (GameState != nullptr) ? GameState->GetServerWorldTimeSeconds() : CurrentWorld->GetTimeSeconds();
+	}
+	return ServerWorldTimeSeconds;
+}
+
+UClass* UProjectileShooterComponent::GetSpawnedProjectileClass() const
+{
+	UClass* SpawnedProjectileClass = ProjectileClass;
+	if (!SoftProjectileClass.IsNull())
+	{
+		// Shots fired before the asynchronous load has finished can't wait for it, so the class is loaded on the spot
+		SpawnedProjectileClass = SoftProjectileClass.Get();
+		if (SpawnedProjectileClass == nullptr)
+		{
+			SpawnedProjectileClass = SoftProjectileClass.LoadSynchronous();
+		}
+	}
+	return SpawnedProjectileClass;
+}
+
+TSubclassOf<AProjectileActor> UProjectileShooterComponent::GetProjectileActorClass() const
+{
+	TSubclassOf<AProjectileActor> ProjectileActorClass = nullptr;
+	UClass* const ShotProjectileClass = GetSpawnedProjectileClass();
+	if ((ShotProjectileClass != nullptr) && ShotProjectileClass->IsChildOf(AProjectileActor::StaticClass()))
+	{
+		ProjectileActorClass = ShotProjectileClass;
+	}
+	return ProjectileActorClass;
+}
+
+void UProjectileShooterComponent::QueueAsyncAutoAimShot(const FVector& InProjectileLocation, const FRotator& InProjectileRotation, int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern, int32 InSpreadSeed)
+{
+	FPendingAutoAimShot PendingShot;
+	PendingShot.ProjectileLocation = InProjectileLocation;
+	PendingShot.ProjectileRotation = InProjectileRotation;
+	PendingShot.RequestFrame = GFrameCounter;
+	PendingShot.NumProjectiles = InNumProjectiles;
+	PendingShot.SpreadPattern = InSpreadPattern;
+	PendingShot.SpreadSeed = InSpreadSeed;
+	FMemMark ScratchMark(FMemStack::Get());
+	FVector OwnerLocation;
+	TScratchArray<FAutoAimCandidate> Candidates;
+	GetAutoAimCandidates(OwnerLocation, Candidates);
+	// Only the traceable candidates are kept until the traces finish, the rest of them go away with the scratch memory
+	PendingShot.Candidates.Append(Candidates.GetData(), GetNumTraceableCandidates(Candidates.Num()));
+	if (PendingShot.Candidates.Num() == 0)
+	{
+		// Without candidates there is nothing to wait for
+		SpawnProjectiles(InProjectileLocation, InProjectileRotation, nullptr, InNumProjectiles, InSpreadPattern, InSpreadSeed);
+	}
+	else
+	{
+		UWorld* const CurrentWorld = GetWorld();
+		for (const FAutoAimCandidate& Candidate : PendingShot.Candidates)
+		{
+			INC_DWORD_STAT(STAT_AutoAimTraces);
+			CSV_CUSTOM_STAT(BerlinByTest, AutoAimTraces, 1, ECsvCustomStatOp::Accumulate);
+			PendingShot.TraceHandles.Add(CurrentWorld->AsyncLineTraceByChannel(EAsyncTraceType::Single, OwnerLocation, Candidate.Location, ECC_GameTraceChannel2));
+		}
+		PendingAutoAimShots.Add(PendingShot);
+		SetComponentTickEnabled(true);
+	}
+}
+
+void UProjectileShooterComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	// The results of the asynchronous traces are available the frame after they were requested
+	int32 NumResolvedShots = 0;
+	while ((NumResolvedShots < PendingAutoAimShots.Num()) && (PendingAutoAimShots[NumResolvedShots].RequestFrame < GFrameCounter))
+	{
+		ResolvePendingAutoAimShot(PendingAutoAimShots[NumResolvedShots]);
+		++NumResolvedShots;
+	}
+	PendingAutoAimShots.RemoveAt(0, NumResolvedShots);
+	if (bUseAutoAimTargetTracking && bTrackAutoAimTargetEveryFrame && ShouldRefreshTrackedTargets())
+	{
+		RefreshTrackedTargets();
+	}
+	UpdateComponentTickEnabled();
+}
+
+void UProjectileShooterComponent::UpdateComponentTickEnabled()
+{
+	const bool bIsTrackingEveryFrame = bUseAutoAimTargetTracking && bTrackAutoAimTargetEveryFrame;
+	SetComponentTickEnabled(bIsTrackingEveryFrame || (PendingAutoAimShots.Num() > 0));
+}
+
+void UProjectileShooterComponent::ResolvePendingAutoAimShot(const FPendingAutoAimShot& InPendingShot)
+{
+	const AActor* AutoAimedActor = nullptr;
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		// Candidates are sorted by score, so the first one which is not occluded is the one to auto-aim to
+		for (int32 CandidateIndex = 0; CandidateIndex < InPendingShot.Candidates.Num(); ++CandidateIndex)
+		{
+			const AActor* const CandidateActor = InPendingShot.Candidates[CandidateIndex].Actor.Get();
+			FTraceDatum TraceDatum;
+			if ((CandidateActor != nullptr) && CurrentWorld->QueryTraceData(InPendingShot.TraceHandles[CandidateIndex], TraceDatum))
+			{
+				if ((TraceDatum.OutHits.Num() > 0) && (TraceDatum.OutHits[0].GetActor() == CandidateActor))
+				{
+					AutoAimedActor = CandidateActor;
+					break;
+				}
+			}
+		}
+	}
+	SpawnProjectiles(InPendingShot.ProjectileLocation, InPendingShot.ProjectileRotation, AutoAimedActor, InPendingShot.NumProjectiles, InPendingShot.SpreadPattern, InPendingShot.SpreadSeed);
+}
+
 int32 UProjectileShooterComponent::GetCurrentAmmo() const
 {
-	return CurrentAmmo;
+	float RegeneratedReloadStartTimeInSeconds;
+	return GetRegeneratedAmmo(RegeneratedReloadStartTimeInSeconds);
 }
 
 bool UProjectileShooterComponent::HasAmmo() const
 {
-	return (CurrentAmmo > 0);
+	return (GetCurrentAmmo() > 0);
 }
 
 bool UProjectileShooterComponent::HasMaximumAmmo() const
 {
-	return (CurrentAmmo >= MaximumAmmo);
+	return (GetCurrentAmmo() >= MaximumAmmo);
 }
 
 void UProjectileShooterComponent::Reload(int32 AmountOfAmmoToReload)
 {
+	SCOPE_CYCLE_COUNTER(STAT_Reload);
+	UpdateRegeneratedAmmo();
 	int32 NewAmmoAfterReload = CurrentAmmo + AmountOfAmmoToReload;
 	if (NewAmmoAfterReload > MaximumAmmo)
 	{
 		NewAmmoAfterReload = MaximumAmmo;
 	}
-	CurrentAmmo = NewAmmoAfterReload;
+	SetCurrentAmmo(NewAmmoAfterReload);
 	/** We invalidate the current cooldown timer, as it has already finished. Also, as this function
 		can be called externaly to reload immediatly, if there was a cooldown going on it is cancelled
 		so that you can't have a cooldown running with full ammo */
@@ -210,6 +1153,9 @@ void UProjectileShooterComponent::Reload(int32 AmountOfAmmoToReload)
 	{
 		TimerManager.ClearTimer(ReloadTimerHandle);
 	}
+	bIsRegeneratingAmmo = false;
+	OnReloadCompleted.Broadcast();
+	OnReloadCompletedNative.Broadcast();
 	// We try to start a new reload cooldown after this reload has completed
 	StartReload();
 }
@@ -219,7 +1165,16 @@ float UProjectileShooterComponent::GetRemainingReloadCooldownInSeconds() const
 	float SecondsRemaining = 0.f;
 	bool bIsTimerManagerValid;
 	FTimerManager& TimerManager = GetTimerManager(bIsTimerManagerValid);
-	if (bIsTimerManagerValid)
+	if (AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp)
+	{
+		// The remaining time is computed from the time at which the current cooldown started
+		float RegeneratedReloadStartTimeInSeconds;
+		if (bIsTimerManagerValid && (GetRegeneratedAmmo(RegeneratedReloadStartTimeInSeconds) < MaximumAmmo))
+		{
+			SecondsRemaining = FMath::Max(RegeneratedReloadStartTimeInSeconds + ReloadCooldownInSeconds - GetWorld()->GetTimeSeconds(), 0.f);
+		}
+	}
+	else if (bIsTimerManagerValid)
 	{
 		SecondsRemaining = TimerManager.GetTimerRemaining(ReloadTimerHandle);
 		if (SecondsRemaining < 0.f)
@@ -229,3 +1184,20 @@ float UProjectileShooterComponent::GetRemainingReloadCooldownInSeconds() const
 	}
 	return SecondsRemaining;
 }
+
+bool UProjectileShooterComponent::IsReloading() const
+{
+	bool bIsReloading = ReloadTimerHandle.IsValid();
+	if (AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp)
+	{
+		bIsReloading = bIsRegeneratingAmmo && !HasMaximumAmmo();
+	}
+	return bIsReloading;
+}
+
+float UProjectileShooterComponent::GetReloadStartTimeInSeconds() const
+{
+	float RegeneratedReloadStartTimeInSeconds;
+	GetRegeneratedAmmo(RegeneratedReloadStartTimeInSeconds);
+	return RegeneratedReloadStartTimeInSeconds;
+}
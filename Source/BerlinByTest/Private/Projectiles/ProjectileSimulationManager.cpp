@@ -0,0 +1,259 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Projectiles/ProjectileSimulationManager.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Core/WorldSingleton.h"
+#include "Projectiles/ProjectileActor.h"
+#include "Projectiles/ProjectileHitDispatcher.h"
+
+DECLARE_CYCLE_STAT(TEXT("Simulate Projectiles"), STAT_SimulateProjectiles, STATGROUP_BerlinByTest);
+DECLARE_CYCLE_STAT(TEXT("Update Projectile Instances"), STAT_UpdateProjectileInstances, STATGROUP_BerlinByTest);
+
+// Sets default values
+AProjectileSimulationManager::AProjectileSimulationManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Projectiles are swept before physics are simulated, so that the physics scene is not modified meanwhile
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	// The instanced meshes are placed in world space, so the manager stays at the origin of the world
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root Component"));
+	bUseParallelSweeps = true;
+	MinimumProjectilesForParallelSweeps = 64;
+}
+
+AProjectileSimulationManager* AProjectileSimulationManager::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AProjectileSimulationManager>(WorldContextObject, bCreateIfMissing);
+}
+
+void AProjectileSimulationManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Batches.Empty();
+	TracerBatches.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+FSimulatedProjectileBatch* AProjectileSimulationManager::GetBatch(TSubclassOf<AProjectileActor> InProjectileClass, bool bInIsVisualOnly)
+{
+	FSimulatedProjectileBatch* Batch = nullptr;
+	UWorld* const CurrentWorld = GetWorld();
+	if ((InProjectileClass != nullptr) && CurrentWorld->IsValidLowLevel())
+	{
+		TMap<UClass*, FSimulatedProjectileBatch>& ClassBatches = bInIsVisualOnly ? TracerBatches : Batches;
+		Batch = ClassBatches.Find(InProjectileClass);
+		if (Batch == nullptr)
+		{
+			// Projectiles are simulated with the same settings the projectile actors of that class would have
+			const AProjectileActor* const DefaultProjectile = InProjectileClass->GetDefaultObject<AProjectileActor>();
+			Batch = &ClassBatches.Add(InProjectileClass);
+			Batch->CollisionProfileName = DefaultProjectile->CollisionComponent->GetCollisionProfileName();
+			Batch->CollisionRadius = DefaultProjectile->CollisionComponent->GetScaledSphereRadius();
+			Batch->InitialSpeed = DefaultProjectile->ProjectileMovementComponent->InitialSpeed;
+			// Tracers follow the straight line of the trace they show
+			Batch->GravityZ = bInIsVisualOnly ? 0.f : CurrentWorld->GetGravityZ() * DefaultProjectile->ProjectileMovementComponent->ProjectileGravityScale;
+			Batch->LifeSpanInSeconds = DefaultProjectile->InitialLifeSpan;
+			Batch->bIsVisualOnly = bInIsVisualOnly;
+			const UStaticMeshComponent* const DefaultMeshComponent = DefaultProjectile->MeshComponent;
+			Batch->MeshRelativeTransform = DefaultMeshComponent->GetRelativeTransform();
+			UInstancedStaticMeshComponent* const InstancedMeshComponent = NewObject<UInstancedStaticMeshComponent>(this);
+			InstancedMeshComponent->SetStaticMesh(DefaultMeshComponent->GetStaticMesh());
+			for (int32 MaterialIndex = 0; MaterialIndex < DefaultMeshComponent->GetNumMaterials(); ++MaterialIndex)
+			{
+				InstancedMeshComponent->SetMaterial(MaterialIndex, DefaultMeshComponent->GetMaterial(MaterialIndex));
+			}
+			InstancedMeshComponent->SetCastShadow(DefaultMeshComponent->CastShadow);
+			// Hits are detected by the sweeps, so the instances don't need any collision
+			InstancedMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			InstancedMeshComponent->SetupAttachment(RootComponent);
+			InstancedMeshComponent->RegisterComponent();
+			Batch->InstancedMeshComponent = InstancedMeshComponent;
+		}
+	}
+	return Batch;
+}
+
+bool AProjectileSimulationManager::FireProjectile(TSubclassOf<AProjectileActor> InProjectileClass, const FVector& InLocation, const FRotator& InRotation, AActor* InShooter)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	bool bHasFiredProjectile = false;
+	FSimulatedProjectileBatch* const Batch = GetBatch(InProjectileClass);
+	if (Batch != nullptr)
+	{
+		/** The parameters are built once per projectile, as they only hold the ids of the ignored actors,
+			which can be read from worker threads */
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SimulatedProjectileSweep), false, this);
+		if (InShooter != nullptr)
+		{
+			QueryParams.AddIgnoredActor(InShooter);
+			if (InShooter->GetOwner() != nullptr)
+			{
+				QueryParams.AddIgnoredActor(InShooter->GetOwner());
+			}
+			if (InShooter->GetInstigator() != nullptr)
+			{
+				QueryParams.AddIgnoredActor(InShooter->GetInstigator());
+			}
+		}
+		Batch->Locations.Add(InLocation);
+		Batch->Velocities.Add(InRotation.Vector() * Batch->InitialSpeed);
+		Batch->RemainingLifeSpans.Add(Batch->LifeSpanInSeconds);
+		Batch->SweepQueryParams.Add(QueryParams);
+		bHasFiredProjectile = true;
+	}
+	return bHasFiredProjectile;
+}
+
+bool AProjectileSimulationManager::FireTracer(TSubclassOf<AProjectileActor> InProjectileClass, const FVector& InLocation, const FRotator& InRotation, float InDistance)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	bool bHasFiredTracer = false;
+	FSimulatedProjectileBatch* const Batch = GetBatch(InProjectileClass, true);
+	if ((Batch != nullptr) && (Batch->InitialSpeed > 0.f))
+	{
+		// The tracer expires once it has flown the whole distance
+		Batch->Locations.Add(InLocation);
+		Batch->Velocities.Add(InRotation.Vector() * Batch->InitialSpeed);
+		Batch->RemainingLifeSpans.Add(InDistance / Batch->InitialSpeed);
+		// Tracers are never swept, but every array of the batch must hold an entry for each projectile
+		Batch->SweepQueryParams.Add(FCollisionQueryParams::DefaultQueryParam);
+		bHasFiredTracer = true;
+	}
+	return bHasFiredTracer;
+}
+
+int32 AProjectileSimulationManager::GetNumSimulatedProjectiles() const
+{
+	int32 NumSimulatedProjectiles = 0;
+	for (const TPair<UClass*, FSimulatedProjectileBatch>& Batch : Batches)
+	{
+		NumSimulatedProjectiles += Batch.Value.Locations.Num();
+	}
+	for (const TPair<UClass*, FSimulatedProjectileBatch>& Batch : TracerBatches)
+	{
+		NumSimulatedProjectiles += Batch.Value.Locations.Num();
+	}
+	return NumSimulatedProjectiles;
+}
+
+void AProjectileSimulationManager::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(Projectiles);
+	Super::Tick(DeltaSeconds);
+	CSV_SCOPED_TIMING_STAT(BerlinByTest, SimulateProjectiles);
+	for (TPair<UClass*, FSimulatedProjectileBatch>& Batch : Batches)
+	{
+		SimulateBatch(Batch.Value, DeltaSeconds);
+		UpdateBatchInstances(Batch.Value);
+	}
+	for (TPair<UClass*, FSimulatedProjectileBatch>& Batch : TracerBatches)
+	{
+		SimulateBatch(Batch.Value, DeltaSeconds);
+		UpdateBatchInstances(Batch.Value);
+	}
+	const int32 NumSimulatedProjectiles = GetNumSimulatedProjectiles();
+	SET_DWORD_STAT(STAT_SimulatedProjectiles, NumSimulatedProjectiles);
+	CSV_CUSTOM_STAT(BerlinByTest, SimulatedProjectiles, NumSimulatedProjectiles, ECsvCustomStatOp::Set);
+}
+
+void AProjectileSimulationManager::SimulateBatch(FSimulatedProjectileBatch& InOutBatch, float InDeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SimulateProjectiles);
+	UWorld* const CurrentWorld = GetWorld();
+	const int32 NumProjectiles = InOutBatch.Locations.Num();
+	if ((NumProjectiles > 0) && CurrentWorld->IsValidLowLevel())
+	{
+		InOutBatch.SweepHits.SetNum(NumProjectiles, false);
+		InOutBatch.SweepHasHit.SetNum(NumProjectiles, false);
+		const FVector GravityVelocityChange(0.f, 0.f, InOutBatch.GravityZ * InDeltaSeconds);
+		if (InOutBatch.bIsVisualOnly)
+		{
+			// Visual-only projectiles never hit anything
+			FMemory::Memzero(InOutBatch.SweepHasHit.GetData(), NumProjectiles * sizeof(bool));
+		}
+		else
+		{
+			const FCollisionShape CollisionShape = FCollisionShape::MakeSphere(InOutBatch.CollisionRadius);
+			// Every projectile is swept from its current location to the one it will have at the end of this frame
+			auto SweepProjectile = [&](int32 InProjectileIndex)
+			{
+				const FVector& StartLocation = InOutBatch.Locations[InProjectileIndex];
+				const FVector EndLocation = StartLocation + InOutBatch.Velocities[InProjectileIndex] * InDeltaSeconds;
+				InOutBatch.SweepHasHit[InProjectileIndex] = CurrentWorld->SweepSingleByProfile(InOutBatch.SweepHits[InProjectileIndex], StartLocation, EndLocation, FQuat::Identity, InOutBatch.CollisionProfileName, CollisionShape, InOutBatch.SweepQueryParams[InProjectileIndex]);
+			};
+			const bool bSweepInParallel = bUseParallelSweeps && (NumProjectiles >= MinimumProjectilesForParallelSweeps);
+			ParallelFor(NumProjectiles, SweepProjectile, !bSweepInParallel);
+		}
+		/** Hits and expirations are handled on the game thread, from the last projectile to the first one so that
+			removing a projectile only moves projectiles that have already been handled */
+		for (int32 ProjectileIndex = NumProjectiles - 1; ProjectileIndex >= 0; --ProjectileIndex)
+		{
+			if (InOutBatch.SweepHasHit[ProjectileIndex])
+			{
+				/** The other actor will be notified that it has been hit by a projectile once every batch has been simulated,
+					as it might fire new projectiles in response to the hit */
+				const FHitResult& SweepHit = InOutBatch.SweepHits[ProjectileIndex];
+				AProjectileHitDispatcher::QueueHit(this, nullptr, SweepHit.GetActor(), SweepHit.ImpactPoint, SweepHit.ImpactNormal);
+				RemoveProjectile(InOutBatch, ProjectileIndex);
+			}
+			else
+			{
+				float& RemainingLifeSpan = InOutBatch.RemainingLifeSpans[ProjectileIndex];
+				RemainingLifeSpan -= InDeltaSeconds;
+				// Projectiles without life span never expire, as it happens with projectile actors, but tracers always do
+				if ((InOutBatch.bIsVisualOnly || (InOutBatch.LifeSpanInSeconds > 0.f)) && (RemainingLifeSpan <= 0.f))
+				{
+					RemoveProjectile(InOutBatch, ProjectileIndex);
+				}
+				else
+				{
+					InOutBatch.Locations[ProjectileIndex] += InOutBatch.Velocities[ProjectileIndex] * InDeltaSeconds;
+					InOutBatch.Velocities[ProjectileIndex] += GravityVelocityChange;
+				}
+			}
+		}
+	}
+}
+
+void AProjectileSimulationManager::RemoveProjectile(FSimulatedProjectileBatch& InOutBatch, int32 InProjectileIndex)
+{
+	InOutBatch.Locations.RemoveAtSwap(InProjectileIndex, 1, false);
+	InOutBatch.Velocities.RemoveAtSwap(InProjectileIndex, 1, false);
+	InOutBatch.RemainingLifeSpans.RemoveAtSwap(InProjectileIndex, 1, false);
+	InOutBatch.SweepQueryParams.RemoveAtSwap(InProjectileIndex, 1, false);
+}
+
+void AProjectileSimulationManager::UpdateBatchInstances(FSimulatedProjectileBatch& InOutBatch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_UpdateProjectileInstances);
+	UInstancedStaticMeshComponent* const InstancedMeshComponent = InOutBatch.InstancedMeshComponent;
+	if (InstancedMeshComponent->IsValidLowLevel())
+	{
+		const int32 NumProjectiles = InOutBatch.Locations.Num();
+		// Instances are only added or removed at the end, so that no other instance needs to be moved around
+		while (InstancedMeshComponent->GetInstanceCount() > NumProjectiles)
+		{
+			InstancedMeshComponent->RemoveInstance(InstancedMeshComponent->GetInstanceCount() - 1);
+		}
+		for (int32 ProjectileIndex = 0; ProjectileIndex < NumProjectiles; ++ProjectileIndex)
+		{
+			const FRotator ProjectileRotation = InOutBatch.Velocities[ProjectileIndex].Rotation();
+			const FTransform ProjectileTransform = InOutBatch.MeshRelativeTransform * FTransform(ProjectileRotation, InOutBatch.Locations[ProjectileIndex]);
+			if (ProjectileIndex < InstancedMeshComponent->GetInstanceCount())
+			{
+				InstancedMeshComponent->UpdateInstanceTransform(ProjectileIndex, ProjectileTransform, true, false, true);
+			}
+			else
+			{
+				InstancedMeshComponent->AddInstanceWorldSpace(ProjectileTransform);
+			}
+		}
+		// The render state is only rebuilt once for the whole batch
+		InstancedMeshComponent->MarkRenderStateDirty();
+	}
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Projectiles/ProjectileSpawnEvent.h"
+#include "GameFramework/Actor.h"
+#include "UObject/CoreNet.h"
+
+FProjectileSpawnEvent::FProjectileSpawnEvent()
+	: Origin(FVector::ZeroVector)
+	, QuantizedYaw(0)
+	, QuantizedPitch(0)
+	, ServerTimeInSeconds(0.f)
+	, Target(nullptr)
+	, BurstSize(1)
+	, NumProjectiles(1)
+	, SpreadPattern(0)
+	, SpreadSeed(0)
+{
+}
+
+FProjectileSpawnEvent::FProjectileSpawnEvent(const FVector& InOrigin, const FRotator& InRotation, float InServerTimeInSeconds, AActor* InTarget)
+	: Origin(InOrigin)
+	, QuantizedYaw(FRotator::CompressAxisToShort(InRotation.Yaw))
+	, QuantizedPitch(FRotator::CompressAxisToShort(InRotation.Pitch))
+	, ServerTimeInSeconds(InServerTimeInSeconds)
+	, Target(InTarget)
+	, BurstSize(1)
+	, NumProjectiles(1)
+	, SpreadPattern(0)
+	, SpreadSeed(0)
+{
+}
+
+FRotator FProjectileSpawnEvent::GetRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(QuantizedPitch), FRotator::DecompressAxisFromShort(QuantizedYaw), 0.f);
+}
+
+bool FProjectileSpawnEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// The origin is rounded to the unit, which is far below what can be noticed on a projectile
+	bool bOriginSuccess = true;
+	Origin.NetSerialize(Ar, Map, bOriginSuccess);
+	Ar << QuantizedYaw;
+	Ar << QuantizedPitch;
+	Ar << ServerTimeInSeconds;
+	// Most shots are not auto-aimed, so a single bit is sent instead of the id of the target when there is none
+	uint8 bHasTarget = ((Target != nullptr) && (Map != nullptr)) ? 1 : 0;
+	Ar.SerializeBits(&bHasTarget, 1);
+	if (bHasTarget != 0)
+	{
+		// A target that isn't known by this machine yet is read as null, which doesn't prevent the projectile from being fired
+		UObject* TargetObject = Target;
+		Map->SerializeObject(Ar, AActor::StaticClass(), TargetObject);
+		Target = Cast<AActor>(TargetObject);
+	}
+	else if (Ar.IsLoading())
+	{
+		Target = nullptr;
+	}
+	// Most shots fire a single projectile, so the spread of the burst is only sent for the ones that fire several
+	uint8 bIsBurst = (BurstSize > 1) ? 1 : 0;
+	Ar.SerializeBits(&bIsBurst, 1);
+	if (bIsBurst != 0)
+	{
+		Ar << BurstSize;
+		Ar << NumProjectiles;
+		Ar << SpreadPattern;
+		Ar << SpreadSeed;
+	}
+	else if (Ar.IsLoading())
+	{
+		BurstSize = 1;
+		NumProjectiles = 1;
+		SpreadPattern = 0;
+		SpreadSeed = 0;
+	}
+	bOutSuccess = bOriginSuccess && !Ar.IsError();
+	return true;
+}
@@ -0,0 +1,446 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Replay/SessionRecorder.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Core/WorldSingleton.h"
+#include "Projectiles/ProjectileShooterComponent.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSessionRecorder, Log, All);
+
+// Identifies session files, and changes whenever their format does
+static const uint32 SessionFileMagic = 0x53544242;
+static const int32 SessionFileVersion = 1;
+
+// Bits of the flags written at the start of each frame, telling which input comes after them
+enum ESessionFrameFlags : uint8
+{
+	SessionFrame_MoveForward = 1 << 0,
+	SessionFrame_MoveRight = 1 << 1,
+	SessionFrame_Turn = 1 << 2,
+	SessionFrame_LookUp = 1 << 3,
+	SessionFrame_JumpPressed = 1 << 4,
+	SessionFrame_JumpReleased = 1 << 5,
+	SessionFrame_Shots = 1 << 6,
+	SessionFrame_AutoAimTargets = 1 << 7
+};
+
+// Sets default values
+ASessionRecorder::ASessionRecorder()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	State = ESessionRecorderState::Idle;
+	RandomSeed = 0;
+	NumRecordedFrames = 0;
+	NextReplayFrameIndex = 0;
+	LastReplayFrameTime = 0.0;
+	NumAutoAimMismatches = 0;
+}
+
+ASessionRecorder* ASessionRecorder::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<ASessionRecorder>(WorldContextObject, bCreateIfMissing);
+}
+
+void ASessionRecorder::StartFromCommandLine(APlayerController* InPlayerController)
+{
+	// Only the first map of the run is recorded or replayed
+	static bool bHasStartedFromCommandLine = false;
+	FString RecordFilePath;
+	FString ReplayFilePath;
+	const bool bShouldRecord = FParse::Value(FCommandLine::Get(), TEXT("BBTRecord="), RecordFilePath);
+	const bool bShouldReplay = FParse::Value(FCommandLine::Get(), TEXT("BBTReplay="), ReplayFilePath);
+	if (!bHasStartedFromCommandLine && (bShouldRecord || bShouldReplay))
+	{
+		bHasStartedFromCommandLine = true;
+		ASessionRecorder* const SessionRecorder = Get(InPlayerController);
+		if (SessionRecorder->IsValidLowLevel())
+		{
+			if (bShouldReplay)
+			{
+				if (!SessionRecorder->StartReplay(ReplayFilePath))
+				{
+					FPlatformMisc::RequestExit(false);
+				}
+			}
+			else
+			{
+				SessionRecorder->StartRecording(RecordFilePath);
+			}
+		}
+	}
+}
+
+bool ASessionRecorder::StartRecording(const FString& InFilePath)
+{
+	bool bHasStarted = false;
+	if (State == ESessionRecorderState::Idle)
+	{
+		bHasStarted = true;
+		State = ESessionRecorderState::Recording;
+		SessionFilePath = GetSessionFilePath(InFilePath);
+		RecordedFrameData.Reset();
+		NumRecordedFrames = 0;
+		CurrentAutoAimTargets.Reset();
+		int32 CommandLineSeed;
+		SetRandomSeed(FParse::Value(FCommandLine::Get(), TEXT("BBTSeed="), CommandLineSeed) ? CommandLineSeed : static_cast<int32>(FPlatformTime::Cycles()));
+		UE_LOG(LogSessionRecorder, Display, TEXT("Recording session of %s with seed %d to %s"), *GetMapName(), RandomSeed, *SessionFilePath);
+	}
+	return bHasStarted;
+}
+
+void ASessionRecorder::StopRecording()
+{
+	if (State == ESessionRecorderState::Recording)
+	{
+		State = ESessionRecorderState::Idle;
+		BindCharacter(nullptr);
+		TArray<uint8> SessionData;
+		FMemoryWriter Writer(SessionData, true);
+		uint32 Magic = SessionFileMagic;
+		int32 Version = SessionFileVersion;
+		FString MapName = GetMapName();
+		Writer << Magic;
+		Writer << Version;
+		Writer << MapName;
+		Writer << RandomSeed;
+		Writer << NumRecordedFrames;
+		Writer.Serialize(RecordedFrameData.GetData(), RecordedFrameData.Num());
+		if (FFileHelper::SaveArrayToFile(SessionData, *SessionFilePath))
+		{
+			UE_LOG(LogSessionRecorder, Display, TEXT("Recorded %d frames (%d bytes) to %s"), NumRecordedFrames, SessionData.Num(), *SessionFilePath);
+		}
+		else
+		{
+			UE_LOG(LogSessionRecorder, Error, TEXT("The recorded session couldn't be written to %s"), *SessionFilePath);
+		}
+		RecordedFrameData.Empty();
+	}
+}
+
+bool ASessionRecorder::StartReplay(const FString& InFilePath)
+{
+	bool bHasStarted = false;
+	TArray<uint8> SessionData;
+	const FString FilePath = GetSessionFilePath(InFilePath);
+	if (State != ESessionRecorderState::Idle)
+	{
+		UE_LOG(LogSessionRecorder, Error, TEXT("A session is already being recorded or replayed"));
+	}
+	else if (!FFileHelper::LoadFileToArray(SessionData, *FilePath))
+	{
+		UE_LOG(LogSessionRecorder, Error, TEXT("The session %s couldn't be loaded"), *FilePath);
+	}
+	else
+	{
+		FMemoryReader Reader(SessionData, true);
+		uint32 Magic = 0;
+		int32 Version = 0;
+		FString MapName;
+		int32 NumFrames = 0;
+		Reader << Magic;
+		Reader << Version;
+		if ((Magic != SessionFileMagic) || (Version != SessionFileVersion))
+		{
+			UE_LOG(LogSessionRecorder, Error, TEXT("%s is not a session file or was recorded by another version of the game"), *FilePath);
+		}
+		else
+		{
+			int32 SessionRandomSeed = 0;
+			Reader << MapName;
+			Reader << SessionRandomSeed;
+			Reader << NumFrames;
+			ReplayFrames.Reset();
+			ReplayFrames.SetNum(FMath::Max(NumFrames, 0));
+			for (FRecordedFrame& Frame : ReplayFrames)
+			{
+				SerializeFrame(Reader, Frame);
+			}
+			if (Reader.IsError())
+			{
+				UE_LOG(LogSessionRecorder, Error, TEXT("The session %s is truncated or corrupted"), *FilePath);
+			}
+			else
+			{
+				bHasStarted = true;
+				if (MapName != GetMapName())
+				{
+					UE_LOG(LogSessionRecorder, Warning, TEXT("The session was recorded on %s but is being replayed on %s"), *MapName, *GetMapName());
+				}
+				State = ESessionRecorderState::Replaying;
+				SessionFilePath = FilePath;
+				NextReplayFrameIndex = 0;
+				NumAutoAimMismatches = 0;
+				ReplayedFrames.Reset(ReplayFrames.Num());
+				CurrentAutoAimTargets.Reset();
+				LastReplayFrameTime = FPlatformTime::Seconds();
+				SetRandomSeed(SessionRandomSeed);
+				// Every frame lasts as long as it did when it was recorded, regardless of how long it takes to run it
+				FApp::SetUseFixedTimeStep(true);
+				SetNextFrameDeltaSeconds();
+				UE_LOG(LogSessionRecorder, Display, TEXT("Replaying %d frames recorded with seed %d from %s"), ReplayFrames.Num(), RandomSeed, *SessionFilePath);
+			}
+		}
+	}
+	return bHasStarted;
+}
+
+bool ASessionRecorder::IsRecording() const
+{
+	return (State == ESessionRecorderState::Recording);
+}
+
+bool ASessionRecorder::IsReplaying() const
+{
+	return (State == ESessionRecorderState::Replaying);
+}
+
+void ASessionRecorder::RecordInputFrame(ABerlinByTestCharacter* InCharacter, const FCharacterInputFrame& InInputFrame, float InDeltaSeconds)
+{
+	if (IsRecording())
+	{
+		BindCharacter(InCharacter);
+		FRecordedFrame Frame;
+		Frame.DeltaSeconds = InDeltaSeconds;
+		Frame.Input = InInputFrame;
+		Frame.AutoAimTargets = MoveTemp(CurrentAutoAimTargets);
+		CurrentAutoAimTargets.Reset();
+		FMemoryWriter Writer(RecordedFrameData, true, true);
+		SerializeFrame(Writer, Frame);
+		++NumRecordedFrames;
+	}
+}
+
+void ASessionRecorder::ReplayInputFrame(ABerlinByTestCharacter* InCharacter, float InDeltaSeconds)
+{
+	// Frames are only recorded while the player has a character, so they are only replayed while it has one as well
+	if (IsReplaying() && (InCharacter != nullptr))
+	{
+		if (NextReplayFrameIndex >= ReplayFrames.Num())
+		{
+			FinishReplay();
+		}
+		else
+		{
+			const FRecordedFrame& Frame = ReplayFrames[NextReplayFrameIndex];
+			++NextReplayFrameIndex;
+			SetNextFrameDeltaSeconds();
+			BindCharacter(InCharacter);
+			InCharacter->ApplyInputFrame(Frame.Input);
+			InCharacter->ConsumeInputFrame();
+			/** Just like when recording, the frame gets the auto-aim decisions taken since the previous one. Shots that auto-aim
+				to a different actor than when they were recorded mean that the session has diverged */
+			if (CurrentAutoAimTargets != Frame.AutoAimTargets)
+			{
+				++NumAutoAimMismatches;
+				UE_LOG(LogSessionRecorder, Warning, TEXT("Frame %d: the auto-aim decisions differ from the recorded ones"), NextReplayFrameIndex - 1);
+			}
+			CurrentAutoAimTargets.Reset();
+			const double CurrentTime = FPlatformTime::Seconds();
+			FReplayedFrame ReplayedFrame;
+			ReplayedFrame.DeltaSeconds = InDeltaSeconds;
+			ReplayedFrame.FrameTimeInSeconds = CurrentTime - LastReplayFrameTime;
+			ReplayedFrame.CharacterLocation = InCharacter->GetActorLocation();
+			ReplayedFrame.ControlYaw = InCharacter->GetControlRotation().Yaw;
+			const UProjectileShooterComponent* const ShooterComponent = InCharacter->GetProjectileShooterComponent();
+			ReplayedFrame.CurrentAmmo = (ShooterComponent != nullptr) ? ShooterComponent->GetCurrentAmmo() : 0;
+			ReplayedFrames.Add(ReplayedFrame);
+			LastReplayFrameTime = CurrentTime;
+		}
+	}
+}
+
+void ASessionRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Sessions recorded until the game ends are written when it does
+	StopRecording();
+	BindCharacter(nullptr);
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASessionRecorder::SerializeFrame(FArchive& Ar, FRecordedFrame& InOutFrame)
+{
+	FCharacterInputFrame& Input = InOutFrame.Input;
+	uint8 Flags = 0;
+	if (Ar.IsSaving())
+	{
+		Flags |= (Input.MoveForward != 0.f) ? SessionFrame_MoveForward : 0;
+		Flags |= (Input.MoveRight != 0.f) ? SessionFrame_MoveRight : 0;
+		Flags |= (Input.Turn != 0.f) ? SessionFrame_Turn : 0;
+		Flags |= (Input.LookUp != 0.f) ? SessionFrame_LookUp : 0;
+		Flags |= Input.bJumpPressed ? SessionFrame_JumpPressed : 0;
+		Flags |= Input.bJumpReleased ? SessionFrame_JumpReleased : 0;
+		Flags |= (Input.NumShots > 0) ? SessionFrame_Shots : 0;
+		Flags |= (InOutFrame.AutoAimTargets.Num() > 0) ? SessionFrame_AutoAimTargets : 0;
+	}
+	Ar << Flags;
+	Ar << InOutFrame.DeltaSeconds;
+	// The axes are kept at full precision, as the small errors of quantizing them would add up over the session
+	if (Flags & SessionFrame_MoveForward)
+	{
+		Ar << Input.MoveForward;
+	}
+	if (Flags & SessionFrame_MoveRight)
+	{
+		Ar << Input.MoveRight;
+	}
+	if (Flags & SessionFrame_Turn)
+	{
+		Ar << Input.Turn;
+	}
+	if (Flags & SessionFrame_LookUp)
+	{
+		Ar << Input.LookUp;
+	}
+	Input.bJumpPressed = (Flags & SessionFrame_JumpPressed) != 0;
+	Input.bJumpReleased = (Flags & SessionFrame_JumpReleased) != 0;
+	if (Flags & SessionFrame_Shots)
+	{
+		Ar << Input.NumShots;
+	}
+	if (Flags & SessionFrame_AutoAimTargets)
+	{
+		uint8 NumAutoAimTargets = static_cast<uint8>(FMath::Min(InOutFrame.AutoAimTargets.Num(), 255));
+		Ar << NumAutoAimTargets;
+		InOutFrame.AutoAimTargets.SetNum(NumAutoAimTargets);
+		for (FName& AutoAimTarget : InOutFrame.AutoAimTargets)
+		{
+			Ar << AutoAimTarget;
+		}
+	}
+}
+
+FString ASessionRecorder::GetSessionFilePath(const FString& InFilePath)
+{
+	FString FilePath = InFilePath;
+	if (FPaths::IsRelative(FilePath))
+	{
+		FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Sessions"), FilePath);
+	}
+	return FilePath;
+}
+
+FString ASessionRecorder::GetMapName() const
+{
+	FString MapName;
+	const UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		MapName = CurrentWorld->GetMapName();
+		MapName.RemoveFromStart(CurrentWorld->StreamingLevelsPrefix);
+	}
+	return MapName;
+}
+
+void ASessionRecorder::SetRandomSeed(int32 InRandomSeed)
+{
+	RandomSeed = InRandomSeed;
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+}
+
+void ASessionRecorder::BindCharacter(ABerlinByTestCharacter* InCharacter)
+{
+	if (BoundCharacter.Get() != InCharacter)
+	{
+		UProjectileShooterComponent* const PreviousShooter = BoundCharacter.IsValid() ? BoundCharacter->GetProjectileShooterComponent() : nullptr;
+		if (PreviousShooter != nullptr)
+		{
+			PreviousShooter->OnShotFiredNative.Remove(ShotFiredHandle);
+		}
+		ShotFiredHandle.Reset();
+		BoundCharacter = InCharacter;
+		UProjectileShooterComponent* const Shooter = (InCharacter != nullptr) ? InCharacter->GetProjectileShooterComponent() : nullptr;
+		if (Shooter != nullptr)
+		{
+			ShotFiredHandle = Shooter->OnShotFiredNative.AddUObject(this, &ASessionRecorder::OnShotFired);
+		}
+	}
+}
+
+void ASessionRecorder::OnShotFired(const FVector& InLocation, const FRotator& InRotation, const AActor* InAutoAimedActor)
+{
+	CurrentAutoAimTargets.Add((InAutoAimedActor != nullptr) ? InAutoAimedActor->GetFName() : NAME_None);
+}
+
+void ASessionRecorder::SetNextFrameDeltaSeconds() const
+{
+	if (ReplayFrames.IsValidIndex(NextReplayFrameIndex))
+	{
+		FApp::SetFixedDeltaTime(ReplayFrames[NextReplayFrameIndex].DeltaSeconds);
+	}
+}
+
+void ASessionRecorder::FinishReplay()
+{
+	State = ESessionRecorderState::Idle;
+	BindCharacter(nullptr);
+	FApp::SetUseFixedTimeStep(false);
+	TArray<double> FrameTimesInMilliseconds;
+	FString Csv = TEXT("Frame,DeltaSeconds,FrameTimeMs,LocationX,LocationY,LocationZ,ControlYaw,Ammo\n");
+	for (int32 FrameIndex = 0; FrameIndex < ReplayedFrames.Num(); ++FrameIndex)
+	{
+		const FReplayedFrame& Frame = ReplayedFrames[FrameIndex];
+		const double FrameTimeInMilliseconds = Frame.FrameTimeInSeconds * 1000.0;
+		FrameTimesInMilliseconds.Add(FrameTimeInMilliseconds);
+		Csv += FString::Printf(TEXT("%d,%.6f,%.4f,%.3f,%.3f,%.3f,%.4f,%d\n"), FrameIndex, Frame.DeltaSeconds, FrameTimeInMilliseconds, Frame.CharacterLocation.X, Frame.CharacterLocation.Y, Frame.CharacterLocation.Z, Frame.ControlYaw, Frame.CurrentAmmo);
+	}
+	const FString ReportPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Sessions"), FString::Printf(TEXT("%s-Replay-%s.csv"), *FPaths::GetBaseFilename(SessionFilePath), *FDateTime::Now().ToString()));
+	FFileHelper::SaveStringToFile(Csv, *ReportPath);
+	FrameTimesInMilliseconds.Sort();
+	const int32 NumFrames = FrameTimesInMilliseconds.Num();
+	if (NumFrames > 0)
+	{
+		double TotalFrameTimeInMilliseconds = 0.0;
+		for (const double FrameTimeInMilliseconds : FrameTimesInMilliseconds)
+		{
+			TotalFrameTimeInMilliseconds += FrameTimeInMilliseconds;
+		}
+		UE_LOG(LogSessionRecorder, Display, TEXT("Replayed %d frames: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms"), NumFrames, TotalFrameTimeInMilliseconds / NumFrames,
+			FrameTimesInMilliseconds[NumFrames / 2], FrameTimesInMilliseconds[FMath::Min(NumFrames * 99 / 100, NumFrames - 1)], FrameTimesInMilliseconds.Last());
+	}
+	if (NumAutoAimMismatches > 0)
+	{
+		UE_LOG(LogSessionRecorder, Error, TEXT("The auto-aim decisions of %d frames differ from the recorded ones, so the replay has diverged"), NumAutoAimMismatches);
+	}
+	UE_LOG(LogSessionRecorder, Display, TEXT("Replay report written to %s"), *ReportPath);
+	FPlatformMisc::RequestExit(false);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs StartRecordingCommand(
+	TEXT("BerlinByTest.Session.Record"),
+	TEXT("Starts recording the play session to the given file, relative to Saved/Sessions. It is written when recording stops or the game ends."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		ASessionRecorder* const SessionRecorder = ASessionRecorder::Get(World);
+		if (SessionRecorder->IsValidLowLevel())
+		{
+			const FString FileName = (Args.Num() > 0) ? Args[0] : FString::Printf(TEXT("Session-%s.bbtsession"), *FDateTime::Now().ToString());
+			if (!SessionRecorder->StartRecording(FileName))
+			{
+				UE_LOG(LogSessionRecorder, Error, TEXT("A session is already being recorded or replayed"));
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs StopRecordingCommand(
+	TEXT("BerlinByTest.Session.StopRecording"),
+	TEXT("Stops recording the play session and writes it to its file."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		ASessionRecorder* const SessionRecorder = ASessionRecorder::Get(World, false);
+		if (SessionRecorder->IsValidLowLevel())
+		{
+			SessionRecorder->StopRecording();
+		}
+	}));
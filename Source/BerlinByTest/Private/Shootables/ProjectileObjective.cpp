@@ -1,7 +1,9 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Shootables/ProjectileObjective.h"
+#include "BerlinByTest.h"
 #include "Components/StaticMeshComponent.h"
+#include "Shootables/ShootableRegistry.h"
 
 // Sets default values
 AProjectileObjective::AProjectileObjective()
@@ -14,10 +16,36 @@ AProjectileObjective::AProjectileObjective()
 // Called when the game starts or when spawned
 void AProjectileObjective::BeginPlay()
 {
+	BERLINBYTEST_LLM_SCOPE(Shootables);
 	Super::BeginPlay();
+	// Make this objective available for auto-aiming
+	AShootableRegistry::RegisterShootable(this);
+}
+
+void AProjectileObjective::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AShootableRegistry::UnregisterShootable(this);
+	Super::EndPlay(EndPlayReason);
 }
 
 float AProjectileObjective::GetAutoAimPriority_Implementation() const
 {
 	return AutoAimPriority;
 }
+
+void AProjectileObjective::SetAutoAimPriority(float InAutoAimPriority)
+{
+	AutoAimPriority = InAutoAimPriority;
+	AShootableRegistry::NotifyShootablePriorityChanged(this);
+}
+
+#if WITH_EDITOR
+void AProjectileObjective::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(AProjectileObjective, AutoAimPriority))
+	{
+		AShootableRegistry::NotifyShootablePriorityChanged(this);
+	}
+}
+#endif
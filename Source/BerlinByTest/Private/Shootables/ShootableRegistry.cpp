@@ -0,0 +1,371 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Shootables/ShootableRegistry.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Components/SceneComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Core/WorldSingleton.h"
+#include "Shootables/Shootable.h"
+
+#if !UE_BUILD_SHIPPING
+DEFINE_LOG_CATEGORY_STATIC(LogShootableRegistry, Log, All);
+
+static TAutoConsoleVariable<int32> CVarCheckShootablePriorities(
+	TEXT("BerlinByTest.Shootables.CheckPriorities"),
+	0,
+	TEXT("Reads the auto-aim priority of every registered shootable every frame, warning about the ones whose priority changed\n")
+	TEXT("without NotifyShootablePriorityChanged being called.\n")
+	TEXT("0: Off\n")
+	TEXT("1: On"),
+	ECVF_Cheat);
+#endif
+
+// Sets default values
+AShootableRegistry::AShootableRegistry()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Movable shootables are relocated in the grid once everything has moved this frame
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+	CellSize = 2000.f;
+}
+
+AShootableRegistry* AShootableRegistry::Get(const UObject* WorldContextObject, bool bCreateIfMissing)
+{
+	return GetWorldSingleton<AShootableRegistry>(WorldContextObject, bCreateIfMissing);
+}
+
+void AShootableRegistry::PostInitializeComponents()
+{
+	BERLINBYTEST_LLM_SCOPE(Shootables);
+	Super::PostInitializeComponents();
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		/** Shootables implemented in Blueprints can't be expected to register themselves, so every actor already
+			in the world is checked once and every actor spawned from now on is checked when it is spawned */
+		for (TActorIterator<AActor> It(CurrentWorld); It; ++It)
+		{
+			AddShootable(*It);
+		}
+		ActorSpawnedHandle = CurrentWorld->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &AShootableRegistry::OnActorSpawned));
+	}
+}
+
+void AShootableRegistry::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UWorld* const CurrentWorld = GetWorld();
+	if (CurrentWorld->IsValidLowLevel())
+	{
+		CurrentWorld->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	Entries.Empty();
+	EntryIndicesByActor.Empty();
+	EntryIndicesByCell.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AShootableRegistry::RegisterShootable(AActor* InShootableActor)
+{
+	BERLINBYTEST_LLM_SCOPE(Shootables);
+	AShootableRegistry* const ShootableRegistry = Get(InShootableActor);
+	if (ShootableRegistry->IsValidLowLevel())
+	{
+		ShootableRegistry->AddShootable(InShootableActor);
+	}
+}
+
+void AShootableRegistry::UnregisterShootable(AActor* InShootableActor)
+{
+	// There is no need to create a registry just to remove an actor from it
+	AShootableRegistry* const ShootableRegistry = Get(InShootableActor, false);
+	if (ShootableRegistry->IsValidLowLevel())
+	{
+		ShootableRegistry->RemoveShootable(InShootableActor);
+	}
+}
+
+void AShootableRegistry::NotifyShootablePriorityChanged(AActor* InShootableActor)
+{
+	AShootableRegistry* const ShootableRegistry = Get(InShootableActor, false);
+	if (ShootableRegistry->IsValidLowLevel())
+	{
+		const int32* const EntryIndex = ShootableRegistry->EntryIndicesByActor.Find(InShootableActor);
+		if (EntryIndex != nullptr)
+		{
+			FShootableEntry& Entry = ShootableRegistry->Entries[*EntryIndex];
+			Entry.AutoAimPriority = ReadShootablePriority(InShootableActor);
+#if !UE_BUILD_SHIPPING
+			Entry.bHasReportedPriorityDrift = false;
+#endif
+		}
+	}
+}
+
+float AShootableRegistry::GetShootablePriority(const AActor* InShootableActor) const
+{
+	const int32* const EntryIndex = EntryIndicesByActor.Find(InShootableActor);
+	return (EntryIndex != nullptr) ? Entries[*EntryIndex].AutoAimPriority : 0.f;
+}
+
+float AShootableRegistry::ReadShootablePriority(AActor* InShootableActor)
+{
+	return FMath::Clamp(IShootable::Execute_GetAutoAimPriority(InShootableActor), 0.f, 10.f);
+}
+
+void AShootableRegistry::AddShootable(AActor* InShootableActor)
+{
+	if (InShootableActor->IsValidLowLevel() && !InShootableActor->IsPendingKill() && !EntryIndicesByActor.Contains(InShootableActor))
+	{
+		if (InShootableActor->GetClass()->ImplementsInterface(UShootable::StaticClass()))
+		{
+			FShootableEntry NewEntry;
+			NewEntry.Actor = InShootableActor;
+			NewEntry.Cell = GetCell(InShootableActor->GetActorLocation());
+			const USceneComponent* const ShootableRoot = InShootableActor->GetRootComponent();
+			NewEntry.bIsMovable = (ShootableRoot == nullptr) || (ShootableRoot->Mobility == EComponentMobility::Movable);
+			NewEntry.AutoAimPriority = ReadShootablePriority(InShootableActor);
+#if !UE_BUILD_SHIPPING
+			NewEntry.bHasReportedPriorityDrift = false;
+#endif
+			const int32 NewEntryIndex = Entries.Add(NewEntry);
+			EntryIndicesByActor.Add(InShootableActor, NewEntryIndex);
+			AddEntryToCell(NewEntryIndex);
+			InShootableActor->OnEndPlay.AddUniqueDynamic(this, &AShootableRegistry::OnShootableEndPlay);
+		}
+	}
+}
+
+void AShootableRegistry::RemoveShootable(AActor* InShootableActor)
+{
+	int32 EntryIndex;
+	if (EntryIndicesByActor.RemoveAndCopyValue(InShootableActor, EntryIndex))
+	{
+		RemoveEntryFromCell(EntryIndex);
+		Entries.RemoveAt(EntryIndex);
+		if (InShootableActor->IsValidLowLevel())
+		{
+			InShootableActor->OnEndPlay.RemoveDynamic(this, &AShootableRegistry::OnShootableEndPlay);
+		}
+	}
+}
+
+void AShootableRegistry::OnActorSpawned(AActor* InSpawnedActor)
+{
+	AddShootable(InSpawnedActor);
+}
+
+void AShootableRegistry::OnShootableEndPlay(AActor* InActor, EEndPlayReason::Type InEndPlayReason)
+{
+	RemoveShootable(InActor);
+}
+
+FIntVector AShootableRegistry::GetCell(const FVector& InLocation) const
+{
+	const FVector CellLocation = InLocation / CellSize;
+	return FIntVector(FMath::FloorToInt(CellLocation.X), FMath::FloorToInt(CellLocation.Y), FMath::FloorToInt(CellLocation.Z));
+}
+
+void AShootableRegistry::AddEntryToCell(int32 InEntryIndex)
+{
+	EntryIndicesByCell.FindOrAdd(Entries[InEntryIndex].Cell).Add(InEntryIndex);
+}
+
+void AShootableRegistry::RemoveEntryFromCell(int32 InEntryIndex)
+{
+	const FIntVector& EntryCell = Entries[InEntryIndex].Cell;
+	TArray<int32>* const CellEntryIndices = EntryIndicesByCell.Find(EntryCell);
+	if (CellEntryIndices != nullptr)
+	{
+		CellEntryIndices->RemoveSwap(InEntryIndex);
+		// Empty cells are removed so that queries without distance limit only visit cells with shootables
+		if (CellEntryIndices->Num() == 0)
+		{
+			EntryIndicesByCell.Remove(EntryCell);
+		}
+	}
+}
+
+void AShootableRegistry::Tick(float DeltaSeconds)
+{
+	BERLINBYTEST_LLM_SCOPE(Shootables);
+	Super::Tick(DeltaSeconds);
+	// Relocate every movable shootable that has changed its cell since the last frame
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FShootableEntry& Entry = *It;
+		const AActor* const ShootableActor = Entry.Actor.Get();
+		if (Entry.bIsMovable && (ShootableActor != nullptr))
+		{
+			const FIntVector NewCell = GetCell(ShootableActor->GetActorLocation());
+			if (NewCell != Entry.Cell)
+			{
+				RemoveEntryFromCell(It.GetIndex());
+				Entry.Cell = NewCell;
+				AddEntryToCell(It.GetIndex());
+			}
+		}
+	}
+#if !UE_BUILD_SHIPPING
+	// The cached priorities are compared with the current ones, each drifted shootable being reported once until it notifies a change
+	if (CVarCheckShootablePriorities.GetValueOnGameThread() != 0)
+	{
+		for (FShootableEntry& Entry : Entries)
+		{
+			AActor* const ShootableActor = Entry.Actor.Get();
+			if ((ShootableActor != nullptr) && !Entry.bHasReportedPriorityDrift)
+			{
+				const float CurrentPriority = ReadShootablePriority(ShootableActor);
+				if (!FMath::IsNearlyEqual(CurrentPriority, Entry.AutoAimPriority))
+				{
+					UE_LOG(LogShootableRegistry, Warning, TEXT("%s has an auto-aim priority of %f, but the registry still uses %f. NotifyShootablePriorityChanged must be called whenever it changes"), *ShootableActor->GetName(), CurrentPriority, Entry.AutoAimPriority);
+					Entry.bHasReportedPriorityDrift = true;
+				}
+			}
+		}
+	}
+#endif
+}
+
+void AShootableRegistry::GetShootablesInCone(const FVector& InOrigin, const FVector& InForwardVector, float InCosineOfMaximumAngle, float InMaximumDistance, TScratchArray<FShootableQueryResult>& OutShootables) const
+{
+	OutShootables.Reset();
+	ForEachShootableNearCone(InOrigin, InForwardVector, InCosineOfMaximumAngle, InMaximumDistance, [&](AActor* InShootableActor, float InAutoAimPriority)
+	{
+		TestShootableAgainstCone(InShootableActor, InAutoAimPriority, InOrigin, InForwardVector, InCosineOfMaximumAngle, InMaximumDistance, OutShootables);
+	});
+}
+
+void AShootableRegistry::ForEachShootableNearCone(const FVector& InOrigin, const FVector& InForwardVector, float InCosineOfMaximumAngle, float InMaximumDistance, TFunctionRef<void(AActor*, float)> InVisitor) const
+{
+	if (InMaximumDistance <= 0.f)
+	{
+		// Without a distance limit every shootable has to be checked
+		for (const FShootableEntry& Entry : Entries)
+		{
+			AActor* const ShootableActor = Entry.Actor.Get();
+			if (ShootableActor != nullptr)
+			{
+				InVisitor(ShootableActor, Entry.AutoAimPriority);
+			}
+		}
+	}
+	else
+	{
+		/** A cell is only visited if its bounding sphere intersects the cone. Shootables are stored in the cell
+			in which they were at the end of the last frame, so the margin lets shootables that have moved
+			a bit since then still be found */
+		const float CellRadius = CellSize * 0.5f * FMath::Sqrt(3.f);
+		const float CellMargin = CellSize * 0.25f;
+		const float MaximumAngle = FMath::Acos(FMath::Clamp(InCosineOfMaximumAngle, -1.f, 1.f));
+		const FIntVector MinimumCell = GetCell(InOrigin - FVector(InMaximumDistance + CellMargin));
+		const FIntVector MaximumCell = GetCell(InOrigin + FVector(InMaximumDistance + CellMargin));
+		auto DoesCellIntersectCone = [&](const FIntVector& InCell)
+		{
+			if ((InCell.X < MinimumCell.X) || (InCell.Y < MinimumCell.Y) || (InCell.Z < MinimumCell.Z)
+				|| (InCell.X > MaximumCell.X) || (InCell.Y > MaximumCell.Y) || (InCell.Z > MaximumCell.Z))
+			{
+				return false;
+			}
+			const FVector CellCenter = (FVector(InCell.X, InCell.Y, InCell.Z) + FVector(0.5f)) * CellSize;
+			FVector VectorToCell = CellCenter - InOrigin;
+			const float DistanceToCell = VectorToCell.Size();
+			const float CellCullingRadius = CellRadius + CellMargin;
+			if (DistanceToCell <= CellCullingRadius)
+			{
+				return true;
+			}
+			if (DistanceToCell - CellCullingRadius >= InMaximumDistance)
+			{
+				return false;
+			}
+			VectorToCell /= DistanceToCell;
+			const float AngleToCell = FMath::Acos(FMath::Clamp(FVector::DotProduct(VectorToCell, InForwardVector), -1.f, 1.f));
+			return AngleToCell <= MaximumAngle + FMath::Asin(CellCullingRadius / DistanceToCell);
+		};
+		auto TestCell = [&](const TArray<int32>& InCellEntryIndices)
+		{
+			for (int32 EntryIndex : InCellEntryIndices)
+			{
+				const FShootableEntry& Entry = Entries[EntryIndex];
+				AActor* const ShootableActor = Entry.Actor.Get();
+				if (ShootableActor != nullptr)
+				{
+					InVisitor(ShootableActor, Entry.AutoAimPriority);
+				}
+			}
+		};
+		const int64 NumCellsInRange = int64(MaximumCell.X - MinimumCell.X + 1) * int64(MaximumCell.Y - MinimumCell.Y + 1) * int64(MaximumCell.Z - MinimumCell.Z + 1);
+		if (NumCellsInRange > EntryIndicesByCell.Num())
+		{
+			// There are fewer occupied cells than cells in range, so it is cheaper to go through the occupied ones
+			for (const TPair<FIntVector, TArray<int32>>& CellEntries : EntryIndicesByCell)
+			{
+				if (DoesCellIntersectCone(CellEntries.Key))
+				{
+					TestCell(CellEntries.Value);
+				}
+			}
+		}
+		else
+		{
+			for (int32 X = MinimumCell.X; X <= MaximumCell.X; ++X)
+			{
+				for (int32 Y = MinimumCell.Y; Y <= MaximumCell.Y; ++Y)
+				{
+					for (int32 Z = MinimumCell.Z; Z <= MaximumCell.Z; ++Z)
+					{
+						const FIntVector Cell(X, Y, Z);
+						const TArray<int32>* const CellEntryIndices = EntryIndicesByCell.Find(Cell);
+						if ((CellEntryIndices != nullptr) && DoesCellIntersectCone(Cell))
+						{
+							TestCell(*CellEntryIndices);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void AShootableRegistry::TestShootableAgainstCone(AActor* InShootableActor, float InAutoAimPriority, const FVector& InOrigin, const FVector& InForwardVector, float InCosineOfMaximumAngle, float InMaximumDistance, TScratchArray<FShootableQueryResult>& OutShootables) const
+{
+	// Check that the actor is within the maximum distance range
+	const FVector ShootableActorLocation = InShootableActor->GetActorLocation();
+	FVector VectorToShootable = ShootableActorLocation - InOrigin;
+	const float DistanceToShootable = VectorToShootable.Size();
+	if ((InMaximumDistance <= 0.f) || (DistanceToShootable < InMaximumDistance))
+	{
+		// Check that the actor is within the selected angle of vision
+		VectorToShootable.Normalize();
+		const float DotProductOfVectors = FVector::DotProduct(VectorToShootable, InForwardVector);
+		if (DotProductOfVectors > InCosineOfMaximumAngle)
+		{
+			FShootableQueryResult QueryResult;
+			QueryResult.Actor = InShootableActor;
+			QueryResult.Location = ShootableActorLocation;
+			QueryResult.Distance = DistanceToShootable;
+			QueryResult.CosineToForward = DotProductOfVectors;
+			QueryResult.AutoAimPriority = InAutoAimPriority;
+			OutShootables.Add(QueryResult);
+		}
+	}
+}
+
+void AShootableRegistry::ForEachShootable(TFunctionRef<void(AActor*, float)> InVisitor) const
+{
+	for (const FShootableEntry& Entry : Entries)
+	{
+		AActor* const ShootableActor = Entry.Actor.Get();
+		if (ShootableActor != nullptr)
+		{
+			InVisitor(ShootableActor, Entry.AutoAimPriority);
+		}
+	}
+}
+
+int32 AShootableRegistry::GetNumShootables() const
+{
+	return Entries.Num();
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "UI/AmmoWidget.h"
+#include "BerlinByTest.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Components/TextBlock.h"
+#include "Components/ProgressBar.h"
+#include "Projectiles/ProjectileShooterComponent.h"
+
+#define LOCTEXT_NAMESPACE "AmmoWidget"
+
+UAmmoWidget::UAmmoWidget(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	AmmoTextFormat = LOCTEXT("AmmoTextFormat", "{CurrentAmmo} / {MaximumAmmo}");
+	bIsReloading = false;
+	ReloadStartTimeInSeconds = 0.f;
+	ReloadDurationInSeconds = 0.f;
+}
+
+void UAmmoWidget::NativeConstruct()
+{
+	BERLINBYTEST_LLM_SCOPE(HUD);
+	Super::NativeConstruct();
+	if (!Shooter.IsValid())
+	{
+		const APawn* const OwningPawn = GetOwningPlayerPawn();
+		if (OwningPawn->IsValidLowLevel())
+		{
+			Shooter = OwningPawn->FindComponentByClass<UProjectileShooterComponent>();
+		}
+	}
+	BindToShooter();
+}
+
+void UAmmoWidget::NativeDestruct()
+{
+	UnbindFromShooter();
+	Super::NativeDestruct();
+}
+
+void UAmmoWidget::SetShooter(UProjectileShooterComponent* InShooter)
+{
+	UnbindFromShooter();
+	Shooter = InShooter;
+	BindToShooter();
+}
+
+void UAmmoWidget::BindToShooter()
+{
+	UProjectileShooterComponent* const CurrentShooter = Shooter.Get();
+	if (CurrentShooter->IsValidLowLevel() && !AmmoChangedHandle.IsValid())
+	{
+		AmmoChangedHandle = CurrentShooter->OnAmmoChangedNative.AddUObject(this, &UAmmoWidget::HandleAmmoChanged);
+		ReloadStartedHandle = CurrentShooter->OnReloadStartedNative.AddUObject(this, &UAmmoWidget::HandleReloadStarted);
+		ReloadCompletedHandle = CurrentShooter->OnReloadCompletedNative.AddUObject(this, &UAmmoWidget::HandleReloadCompleted);
+		// The shooter might have changed before the widget was bound, so its current state is shown right away
+		RefreshFromShooter();
+	}
+}
+
+void UAmmoWidget::RefreshFromShooter()
+{
+	const UProjectileShooterComponent* const CurrentShooter = Shooter.Get();
+	if (CurrentShooter->IsValidLowLevel())
+	{
+		HandleAmmoChanged(CurrentShooter->GetCurrentAmmo(), CurrentShooter->MaximumAmmo);
+		if (CurrentShooter->IsReloading())
+		{
+			HandleReloadStarted(CurrentShooter->GetReloadStartTimeInSeconds(), CurrentShooter->ReloadCooldownInSeconds);
+		}
+		else
+		{
+			HandleReloadCompleted();
+		}
+	}
+}
+
+void UAmmoWidget::UnbindFromShooter()
+{
+	UProjectileShooterComponent* const CurrentShooter = Shooter.Get();
+	if (CurrentShooter->IsValidLowLevel())
+	{
+		CurrentShooter->OnAmmoChangedNative.Remove(AmmoChangedHandle);
+		CurrentShooter->OnReloadStartedNative.Remove(ReloadStartedHandle);
+		CurrentShooter->OnReloadCompletedNative.Remove(ReloadCompletedHandle);
+	}
+	AmmoChangedHandle.Reset();
+	ReloadStartedHandle.Reset();
+	ReloadCompletedHandle.Reset();
+	bIsReloading = false;
+}
+
+void UAmmoWidget::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+{
+	BERLINBYTEST_LLM_SCOPE(HUD);
+	Super::NativeTick(MyGeometry, InDeltaTime);
+	// Only the cooldown bar changes between events, and only while a reload cooldown is running
+	const UWorld* const CurrentWorld = GetWorld();
+	if (bIsReloading && CurrentWorld->IsValidLowLevel())
+	{
+		const float ElapsedTimeInSeconds = CurrentWorld->GetTimeSeconds() - ReloadStartTimeInSeconds;
+		const float ReloadProgress = (ReloadDurationInSeconds > 0.f) ? FMath::Clamp(ElapsedTimeInSeconds / ReloadDurationInSeconds, 0.f, 1.f) : 1.f;
+		SetReloadProgress(ReloadProgress);
+		/** Shooters with timestamp-based regeneration don't notify the ammo reloaded by the passing of time,
+			so their state is read again once the cooldown being animated ends */
+		const UProjectileShooterComponent* const CurrentShooter = Shooter.Get();
+		if ((ReloadProgress >= 1.f) && CurrentShooter->IsValidLowLevel() && (CurrentShooter->AmmoRegenerationMode == EAmmoRegenerationMode::Timestamp))
+		{
+			RefreshFromShooter();
+		}
+	}
+}
+
+void UAmmoWidget::HandleAmmoChanged(int32 InCurrentAmmo, int32 InMaximumAmmo)
+{
+	BERLINBYTEST_LLM_SCOPE(HUD);
+	if (AmmoText->IsValidLowLevel())
+	{
+		FFormatNamedArguments Arguments;
+		Arguments.Add(TEXT("CurrentAmmo"), FText::AsNumber(InCurrentAmmo));
+		Arguments.Add(TEXT("MaximumAmmo"), FText::AsNumber(InMaximumAmmo));
+		AmmoText->SetText(FText::Format(AmmoTextFormat, Arguments));
+	}
+	OnAmmoUpdated(InCurrentAmmo, InMaximumAmmo);
+}
+
+void UAmmoWidget::HandleReloadStarted(float InStartTimeInSeconds, float InDurationInSeconds)
+{
+	bIsReloading = true;
+	ReloadStartTimeInSeconds = InStartTimeInSeconds;
+	ReloadDurationInSeconds = InDurationInSeconds;
+	SetReloadProgress(0.f);
+}
+
+void UAmmoWidget::HandleReloadCompleted()
+{
+	bIsReloading = false;
+	SetReloadProgress(0.f);
+}
+
+void UAmmoWidget::SetReloadProgress(float InReloadProgress)
+{
+	if (ReloadProgressBar->IsValidLowLevel())
+	{
+		ReloadProgressBar->SetPercent(InReloadProgress);
+	}
+	OnReloadProgressUpdated(InReloadProgress);
+}
+
+#undef LOCTEXT_NAMESPACE
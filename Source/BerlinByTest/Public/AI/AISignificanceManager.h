@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "AISignificanceManager.generated.h"
+
+class APawn;
+
+// How often the AI of a significance tier update themselves
+USTRUCT(BlueprintType)
+struct FAISignificanceTier
+{
+	GENERATED_BODY()
+
+	/** AI closer than this distance (in unreal units) to the nearest player camera belong to this tier, unless a previous tier
+		already includes them. If lower or equal to 0, the distance is not limited */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Significance")
+		float MaximumDistance;
+	// Tick interval (in seconds) of the AI actor. If 0, it ticks every frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Significance")
+		float ActorTickInterval;
+	// Tick interval (in seconds) of the movement component of the AI. If 0, it ticks every frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Significance")
+		float MovementTickInterval;
+	// Tick interval (in seconds) of the behavior tree of the AI, which also slows down its services. If 0, it ticks every frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Significance")
+		float BehaviorTreeTickInterval;
+	/** Whether walking AI move along the navigation mesh instead of sweeping against the world to find the floor,
+		which is cheaper but less accurate */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI Significance")
+		bool bUseNavWalking;
+
+	FAISignificanceTier()
+		: MaximumDistance(0.f)
+		, ActorTickInterval(0.f)
+		, MovementTickInterval(0.f)
+		, BehaviorTreeTickInterval(0.f)
+		, bUseNavWalking(false)
+	{
+	}
+};
+
+/** Sorts the AI of the world in significance tiers depending on their distance to the cameras of the player characters,
+	and lowers how often the less significant ones update their actor, movement and behavior tree.
+	AI behind the cameras are considered further away than they are. The tiers are configured in DefaultGame.ini,
+	and BerlinByTest.AI.ShowSignificance draws the tier of every AI */
+UCLASS(config=Game, NotBlueprintable, Transient)
+class BERLINBYTEST_API AAISignificanceManager : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AAISignificanceManager();
+	// Returns the significance manager of the world of the context object, creating it if needed
+	static AAISignificanceManager* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	// Returns the significance tier of an AI, or INDEX_NONE if it has none yet
+	int32 GetSignificanceTier(const APawn* InPawn) const;
+	// Called every time the tiers are updated
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+private:
+	// Returns the tier an AI at the given distance belongs to
+	int32 GetTierForDistance(float InDistance) const;
+	// Applies the settings of a tier to an AI
+	void ApplyTier(APawn* InPawn, int32 InTierIndex) const;
+
+//VARIABLES
+public:
+	// Significance tiers, from the most to the least significant one
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "AI Significance|Configuration")
+		TArray<FAISignificanceTier> Tiers;
+	// How many times further away AI behind the cameras are considered to be
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "AI Significance|Configuration", meta = (ClampMin = "1.0"))
+		float BehindCameraDistanceMultiplier;
+	// How often (in seconds) the tiers of the AI are updated
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "AI Significance|Configuration")
+		float UpdateIntervalInSeconds;
+
+private:
+	// Tier currently applied to each AI
+	TMap<TWeakObjectPtr<APawn>, int32> TierIndicesByPawn;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTDecorator.h"
+#include "BTDecorator_IsTargetClose.generated.h"
+
+/** Checks whether the actor stored in the blackboard is closer than a given distance to the AI.
+	The distance is checked once per frame for every AI by the proximity manager of the world, and observer aborts are
+	only triggered when the target goes from close to far or the other way around */
+UCLASS()
+class BERLINBYTEST_API UBTDecorator_IsTargetClose : public UBTDecorator
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this decorator's properties
+	UBTDecorator_IsTargetClose(const FObjectInitializer& ObjectInitializer);
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+	virtual uint16 GetInstanceMemorySize() const override;
+	virtual void InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const override;
+	virtual void CleanupMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryClear::Type CleanupType) const override;
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	virtual bool CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const override;
+	virtual void OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual void OnCeaseRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+//VARIABLES
+public:
+	// Blackboard key of the actor whose distance is checked
+	UPROPERTY(EditAnywhere, Category = "Is Target Close")
+		FBlackboardKeySelector TargetKey;
+	// Distance (in unreal units) below which the target is considered close
+	UPROPERTY(EditAnywhere, Category = "Is Target Close", meta = (ClampMin = "0.0"))
+		float DistanceCloseEnoughForExplosion;
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTService.h"
+#include "BTService_FindTarget.generated.h"
+
+/** Looks for the nearest visible actor of the selected class and stores it in the blackboard, along with the location
+	where it was last seen. The searches are done by the target search manager of the world, which shares them between
+	nearby AI and spreads them across frames, so this service only reads the latest result every time it ticks */
+UCLASS()
+class BERLINBYTEST_API UBTService_FindTarget : public UBTService
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this service's properties
+	UBTService_FindTarget(const FObjectInitializer& ObjectInitializer);
+	virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+	virtual FString GetStaticDescription() const override;
+
+protected:
+	virtual void TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+
+//VARIABLES
+public:
+	// Class of the actors to look for
+	UPROPERTY(EditAnywhere, Category = "Find Target")
+		TSubclassOf<AActor> TargetClass;
+	// Blackboard key where the target is stored, or cleared if no target can be seen
+	UPROPERTY(EditAnywhere, Category = "Find Target")
+		FBlackboardKeySelector TargetKey;
+	// Blackboard key where the location of the target is stored while it can be seen
+	UPROPERTY(EditAnywhere, Category = "Find Target")
+		FBlackboardKeySelector LastSeenLocationKey;
+	/** Maximum age (in seconds) of the search result used. Older results are still used until a new search is done,
+		which can take a few frames when many AI are searching at the same time */
+	UPROPERTY(EditAnywhere, Category = "Find Target", meta = (ClampMin = "0.0"))
+		float MaximumResultAgeInSeconds;
+};
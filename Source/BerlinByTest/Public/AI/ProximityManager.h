@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "ProximityManager.generated.h"
+
+class UBehaviorTreeComponent;
+class UBTDecorator;
+
+/** Checks once per frame, for every AI watching its blackboard target, whether the target is closer than a given distance.
+	Behavior trees are only asked to evaluate their decorators again when the state of one of them flips */
+UCLASS(NotBlueprintable, Transient)
+class BERLINBYTEST_API AProximityManager : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AProximityManager();
+	// Returns the proximity manager of the world of the context object, creating it if needed
+	static AProximityManager* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	/** Starts watching the distance between the AI of the behavior tree and the actor stored in the blackboard key.
+		Returns the handle of the watch, which is needed to read its state and to stop it */
+	int32 AddWatch(UBehaviorTreeComponent& InOwnerComp, const UBTDecorator* InDecorator, FBlackboard::FKey InTargetKeyID, float InDistance);
+	// Stops watching the distance of a watch
+	void RemoveWatch(int32 InWatchHandle);
+	// Returns true if the target of the watch was closer than its distance the last time it was checked
+	bool IsTargetClose(int32 InWatchHandle) const;
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	struct FProximityWatch
+	{
+		TWeakObjectPtr<UBehaviorTreeComponent> OwnerComp;
+		// Decorator that is notified when the state flips. Decorators are shared by every instance of a tree, so they are never removed before it
+		const UBTDecorator* Decorator;
+		FBlackboard::FKey TargetKeyID;
+		float SquaredDistance;
+		bool bIsTargetClose;
+	};
+	// Returns true if the target of the watch is currently closer than its distance
+	static bool ComputeIsTargetClose(const FProximityWatch& InWatch);
+
+//VARIABLES
+private:
+	TSparseArray<FProximityWatch> Watches;
+};
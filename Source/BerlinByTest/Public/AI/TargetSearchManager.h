@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "TargetSearchManager.generated.h"
+
+// Last known result of a search for a target from a cell of the world
+struct FTargetSearchResult
+{
+	// Nearest visible target found, if any
+	TWeakObjectPtr<AActor> Target;
+	// Location of the target when it was last seen
+	FVector TargetLocation;
+	// World time (in seconds) at which the search was done
+	float SearchTimeInSeconds;
+	// World time (in seconds) at which an AI last asked for the result, so that results nobody asks for anymore can be forgotten
+	float RequestTimeInSeconds;
+
+	FTargetSearchResult()
+		: TargetLocation(FVector::ZeroVector)
+		, SearchTimeInSeconds(0.f)
+		, RequestTimeInSeconds(0.f)
+	{
+	}
+};
+
+/** Searches for targets on behalf of the AI of the world. AI close to each other, i.e. in the same cell of a uniform grid,
+	share the same search result instead of running their own, and searches are spread across frames so that only a
+	limited amount of them is done every frame, no matter how many AI are looking for a target.
+	Results that no AI has asked for in a while, e.g. the ones of cells every AI has left, are forgotten */
+UCLASS(config=Game, NotBlueprintable, Transient)
+class BERLINBYTEST_API ATargetSearchManager : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	ATargetSearchManager();
+	// Returns the search manager of the world of the context object, creating it if needed
+	static ATargetSearchManager* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	/** Returns the last result of the searches of targets of the selected class from the cell of the searcher, if there is one.
+		If there is none or it is older than the maximum age, a new search is queued, whose result will be available
+		in later frames */
+	const FTargetSearchResult* FindTarget(APawn* InSearcher, TSubclassOf<AActor> InTargetClass, float InMaximumResultAgeInSeconds);
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	struct FTargetSearchKey
+	{
+		FIntVector Cell;
+		TWeakObjectPtr<UClass> TargetClass;
+
+		bool operator==(const FTargetSearchKey& Other) const
+		{
+			return (Cell == Other.Cell) && (TargetClass == Other.TargetClass);
+		}
+
+		friend uint32 GetTypeHash(const FTargetSearchKey& InKey)
+		{
+			return HashCombine(GetTypeHash(InKey.Cell), GetTypeHash(InKey.TargetClass));
+		}
+	};
+	struct FPendingTargetSearch
+	{
+		// Any of the AI of the cell, which is used as the origin of the search
+		TWeakObjectPtr<APawn> Searcher;
+		FTargetSearchKey Key;
+	};
+	// Returns the grid cell which contains the given location
+	FIntVector GetCell(const FVector& InLocation) const;
+	/** Finds the nearest target of the selected class which can be seen from the searcher, tracing on the sight trace channel.
+		Neither the searcher nor any other actor is ignored by the traces, as AI pawns are expected to ignore that channel */
+	void RunSearch(const FPendingTargetSearch& InSearch, TArrayView<AActor* const> InTargets);
+	// Forgets the results no AI has asked for during the result lifetime
+	void EvictUnusedResults();
+
+//VARIABLES
+public:
+	// Size (in unreal units) of the side of each cell of the grid. Every AI in the same cell shares the same search result
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Target Search|Configuration")
+		float CellSize;
+	// Maximum amount of searches done every frame. The rest of them wait for the next frames
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Target Search|Configuration")
+		int32 MaximumSearchesPerFrame;
+	/** Channel of the traces that check whether a target can be seen. AI pawns must ignore it, so that they don't block each
+		other's sight, as the Pawn and CharacterMesh collision profiles do with the Visibility channel */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Target Search|Configuration")
+		TEnumAsByte<ECollisionChannel> SightTraceChannel;
+	/** Seconds a result is kept after the last time an AI asked for it. Results are forgotten at most twice as late,
+		as they are only checked once per lifetime */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Target Search|Configuration")
+		float ResultLifetimeInSeconds;
+
+private:
+	TMap<FTargetSearchKey, FTargetSearchResult> Results;
+	// Searches waiting for their turn, from the oldest to the newest one
+	TArray<FPendingTargetSearch> PendingSearches;
+	// Keys of the pending searches, so that a cell is never queued twice
+	TSet<FTargetSearchKey> PendingKeys;
+	// World time (in seconds) at which the unused results will be forgotten next
+	float NextEvictionTimeInSeconds;
+};
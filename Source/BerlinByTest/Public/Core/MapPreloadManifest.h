@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "MapPreloadManifest.generated.h"
+
+/** Lists the assets a map needs as soon as it starts, so that the game mode loads them asynchronously along with the pawn
+	of the players instead of them being loaded synchronously the first time they are used. The manifest of a map is the one
+	named after it, and the asset manager finds the manifests as primary assets of their own type */
+UCLASS(BlueprintType)
+class BERLINBYTEST_API UMapPreloadManifest : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Returns the id of the manifest of the selected map, which may not exist
+	static FPrimaryAssetId GetMapManifestId(const FString& InMapName);
+	// Identifies the manifest by its own type and name, which is the name of its map
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+	// Gathers the paths of every asset and class listed by the manifest
+	void GetAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const;
+
+//VARIABLES
+public:
+	// Primary asset type of every manifest
+	static const FPrimaryAssetType PrimaryAssetType;
+	// Assets loaded before the players are spawned, such as meshes, materials or sounds
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Map Preload Manifest")
+		TArray<TSoftObjectPtr<UObject>> Assets;
+	// Classes loaded before the players are spawned, such as the projectiles or the enemies of the map
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Map Preload Manifest")
+		TArray<TSoftClassPtr<UObject>> Classes;
+};
@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+
+/** Array for the transient results of a gameplay query, allocated linearly from the memory stack of the calling thread
+	instead of the heap, so that queries running every frame don't show up in the malloc profile.
+	Its memory is released when the FMemMark taken before it goes out of scope, so every function that fills one has to take
+	a mark first, and the array must never outlive it, e.g. by being stored in a member or returned.
+	Each thread has its own memory stack, so these arrays can also be used from task graph and ParallelFor workers */
+template<typename InElementType>
+using TScratchArray = TArray<InElementType, TMemStackAllocator<>>;
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+
+/** Returns the actor of the given class that manages the world of the context object, spawning it if it doesn't exist yet.
+	World subsystems are not available in this engine version, so world-wide managers are transient actors that are
+	spawned on demand the first time they are needed. Only game worlds get managers, so this returns null in editor worlds */
+template<typename T>
+T* GetWorldSingleton(const UObject* WorldContextObject, bool bCreateIfMissing = true)
+{
+	static TMap<TWeakObjectPtr<UWorld>, TWeakObjectPtr<T>> WorldSingletons;
+	T* WorldSingleton = nullptr;
+	UWorld* const CurrentWorld = (WorldContextObject != nullptr) ? WorldContextObject->GetWorld() : nullptr;
+	if (CurrentWorld->IsValidLowLevel() && CurrentWorld->IsGameWorld())
+	{
+		const TWeakObjectPtr<T>* const CachedSingleton = WorldSingletons.Find(CurrentWorld);
+		if (CachedSingleton != nullptr)
+		{
+			WorldSingleton = CachedSingleton->Get();
+		}
+		if ((WorldSingleton == nullptr) && bCreateIfMissing && !CurrentWorld->bIsTearingDown)
+		{
+			// Forget the managers of worlds that have already been destroyed before adding a new one
+			for (auto It = WorldSingletons.CreateIterator(); It; ++It)
+			{
+				if (!It.Key().IsValid() || !It.Value().IsValid())
+				{
+					It.RemoveCurrent();
+				}
+			}
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			WorldSingleton = CurrentWorld->SpawnActor<T>(SpawnParameters);
+			WorldSingletons.Add(CurrentWorld, WorldSingleton);
+		}
+	}
+	return WorldSingleton;
+}
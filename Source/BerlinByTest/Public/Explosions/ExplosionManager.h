@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "WorldCollision.h"
+#include "ExplosionManager.generated.h"
+
+class AController;
+class UDamageType;
+class UPrimitiveComponent;
+
+/** Applies the radial damage of every explosion of the world in batches, instead of each explosion running its own queries.
+	Explosions queued during a frame are grouped with the ones they overlap, so that each group does a single overlap query,
+	and explosions at nearly the same location that ignore the same actors share the trace to each damaged component.
+	The damage is the same one ApplyRadialDamage would apply, without falloff and blocked by the damage prevention channel */
+UCLASS(config=Game, NotBlueprintable, Transient)
+class BERLINBYTEST_API AExplosionManager : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AExplosionManager();
+	// Returns the explosion manager of the world of the context object, creating it if needed
+	static AExplosionManager* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	/** Queues an explosion, whose damage will be applied along with the rest of the explosions of this frame.
+		Just like with ApplyRadialDamage, neither the damage causer nor the ignored actors are damaged by the explosion or block
+		its damage, and components can only be damaged if nothing blocks the damage prevention channel between them and the origin.
+		If desired, shootables damaged by the explosion are also notified that they have been hit */
+	UFUNCTION(BlueprintCallable, Category = "Explosions", meta = (WorldContext = "WorldContextObject", AutoCreateRefTerm = "InOrigin,InIgnoreActors"))
+		static void QueueExplosion(const UObject* WorldContextObject, const FVector& InOrigin, float InBaseDamage, float InDamageRadius, TSubclassOf<UDamageType> InDamageTypeClass, const TArray<AActor*>& InIgnoreActors, AActor* InDamageCauser, AController* InInstigatedBy, bool bInNotifyShootables = true, ECollisionChannel InDamagePreventionChannel = ECC_Visibility);
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	struct FQueuedExplosion
+	{
+		FVector Origin;
+		float BaseDamage;
+		float DamageRadius;
+		TSubclassOf<UDamageType> DamageTypeClass;
+		TWeakObjectPtr<AActor> DamageCauser;
+		TWeakObjectPtr<AController> InstigatedBy;
+		bool bNotifyShootables;
+		TArray<TWeakObjectPtr<AActor>> IgnoreActors;
+		TEnumAsByte<ECollisionChannel> DamagePreventionChannel;
+	};
+	// Component that might be damaged by an explosion, if the trace to it is not blocked
+	struct FExplosionVictim
+	{
+		int32 ExplosionIndex;
+		int32 TraceIndex;
+	};
+	// Channel and ignored actors of the traces of the explosions that ignore the same actors on the same channel
+	struct FExplosionTraceParams
+	{
+		TEnumAsByte<ECollisionChannel> Channel;
+		TWeakObjectPtr<AActor> DamageCauser;
+		TArray<TWeakObjectPtr<AActor>> IgnoreActors;
+		FCollisionQueryParams QueryParams;
+	};
+	/** Trace from an explosion origin to a component, shared by every explosion at nearly the same origin
+		with the same trace parameters */
+	struct FExplosionTrace
+	{
+		FVector Start;
+		FVector End;
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		int32 TraceParamsIndex;
+		FTraceHandle TraceHandle;
+		bool bIsVisible;
+		FHitResult Hit;
+	};
+	// Explosions whose damage is applied together
+	struct FExplosionBatch
+	{
+		TArray<FQueuedExplosion> Explosions;
+		TArray<FExplosionVictim> Victims;
+		TArray<FExplosionTrace> Traces;
+		TArray<FExplosionTraceParams> TraceParams;
+		// Frame in which the asynchronous traces were requested, as their results are only available from the next one
+		uint64 TraceFrame;
+	};
+	// Gathers the components each explosion of the batch might damage, along with the traces needed to check them
+	void GatherVictims(FExplosionBatch& InOutBatch) const;
+	// Returns the index of the trace parameters of the explosion in the batch, adding them if no other explosion uses the same ones
+	static int32 FindOrAddTraceParams(FExplosionBatch& InOutBatch, const FQueuedExplosion& InExplosion);
+	// Runs the traces of the batch on the spot
+	void RunTraces(FExplosionBatch& InOutBatch) const;
+	// Requests the traces of the batch, whose results will be available the next frame
+	void RequestAsyncTraces(FExplosionBatch& InOutBatch) const;
+	// Reads the results of the asynchronous traces of the batch
+	void ReadAsyncTraces(FExplosionBatch& InOutBatch) const;
+	// Stores the result of a trace, in the same way ApplyRadialDamage decides whether a component can be damaged
+	static void SetTraceResult(FExplosionTrace& InOutTrace, bool bInHasHit, const FHitResult& InHit);
+	// Applies the damage of every explosion of the batch and notifies the shootables that have been hit
+	void ApplyDamage(const FExplosionBatch& InBatch) const;
+
+//VARIABLES
+public:
+	/** Explosions whose origins are closer than this distance (in unreal units) share the visibility traces to the components
+		they damage */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Explosion Manager|Configuration")
+		float TraceOriginMergeDistance;
+	/** Whether the visibility traces are done asynchronously, applying the damage on the next frame.
+		It avoids spikes when many explosions happen at once, at the cost of a frame of latency */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Explosion Manager|Configuration")
+		bool bUseAsyncTraces;
+
+private:
+	// Explosions queued since the last tick
+	TArray<FQueuedExplosion> QueuedExplosions;
+	// Batches waiting for the results of their asynchronous traces
+	TArray<FExplosionBatch> PendingBatches;
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Projectiles/AutoAimScoring.h"
+#include "AutoAimManager.generated.h"
+
+class UProjectileShooterComponent;
+
+/** Finds the auto-aim target of many shooters at once, e.g. AI turrets and bots. Once per frame, before physics, the positions
+	and priorities of the shootables around the angle of vision of every registered shooter with ammo are copied into read-only
+	arrays, and each shooter is scored against its copy and traces its best candidates on a worker thread. Shooting then uses
+	the target found this frame, so the game thread only pays for the copies of the shootables near the shooters */
+UCLASS(config=Game, NotBlueprintable, Transient)
+class BERLINBYTEST_API AAutoAimManager : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AAutoAimManager();
+	// Returns the auto-aim manager of the world of the context object, creating it if needed
+	static AAutoAimManager* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	// Adds a shooter whose auto-aim target will be found every frame
+	void RegisterShooter(UProjectileShooterComponent* InShooter);
+	// Removes a shooter, which will no longer get auto-aim targets
+	void UnregisterShooter(UProjectileShooterComponent* InShooter);
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	// Called when the manager is being removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Auto-aim target search of a single shooter, with everything the worker threads need copied beforehand
+	struct FAutoAimRequest
+	{
+		UProjectileShooterComponent* Shooter;
+		FAutoAimScoringParameters ScoringParameters;
+		int32 NumTraceableCandidates;
+		// Results of the search
+		AActor* Target;
+		int32 NumCandidates;
+		int32 NumTraces;
+	};
+	/** Scores the copied shootables for a shooter and traces its best candidates until a visible one is found.
+		Safe to run on any thread */
+	void EvaluateRequest(const FAutoAimCandidateBatch& InShootableSnapshot, FAutoAimRequest& InOutRequest) const;
+
+//VARIABLES
+public:
+	// Whether the shooters are evaluated across worker threads
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Auto Aim Manager|Configuration")
+		bool bUseParallelEvaluation;
+	// Minimum amount of shooters looking for a target for them to be evaluated across worker threads
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Auto Aim Manager|Configuration")
+		int32 MinimumShootersForParallelEvaluation;
+
+private:
+	TArray<TWeakObjectPtr<UProjectileShooterComponent>> Shooters;
+	TArray<FAutoAimRequest> Requests;
+};
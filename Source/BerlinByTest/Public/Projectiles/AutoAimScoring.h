@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/ScratchArray.h"
+
+// Auto-aim settings of a shooter, with every value that doesn't depend on the candidates already computed
+struct BERLINBYTEST_API FAutoAimScoringParameters
+{
+	FVector Origin;
+	// Normalized direction in which the shooter is looking
+	FVector ForwardVector;
+	float CosineOfMaximumVisionAngle;
+	// If lower or equal to 0, the distance is not limited and has no weight on the score
+	float MaximumDistance;
+	// Weight of each term, already divided by the sum of the weights and by the maximum value of the term
+	float PriorityFactor;
+	float FocusFactor;
+	float DistanceFactor;
+	// False if the sum of the weights is not positive, in which case every candidate scores 0
+	bool bCanScore;
+
+	// Computes the parameters from the auto-aim configuration of a shooter
+	static FAutoAimScoringParameters Make(const FVector& InOrigin, const FVector& InForwardVector, float InMaximumVisionAngle, float InMaximumDistance, float InPriorityWeight, float InDistanceWeight, float InFocusWeight);
+};
+
+/** Candidates to be auto-aimed, with each attribute packed in its own array so that several candidates can be scored at once.
+	The arrays are scratch arrays, so the caller must take an FMemMark before filling the batch, and the batch must not outlive it */
+struct BERLINBYTEST_API FAutoAimCandidateBatch
+{
+	TScratchArray<AActor*> Actors;
+	TScratchArray<float> LocationsX;
+	TScratchArray<float> LocationsY;
+	TScratchArray<float> LocationsZ;
+	TScratchArray<float> Priorities;
+
+	// Makes room for the selected amount of candidates, so that the arrays are not reallocated on the memory stack while being filled
+	void Reserve(int32 InNumCandidates);
+	// Adds a candidate at the end of the batch
+	void Add(AActor* InActor, const FVector& InLocation, float InPriority);
+	// Removes every candidate, keeping the memory allocated
+	void Reset();
+	// Returns how many candidates there are in the batch
+	int32 Num() const;
+	// Returns the location of a candidate
+	FVector GetLocation(int32 InCandidateIndex) const;
+};
+
+/** Scores every candidate of the batch, four at a time. Candidates outside the maximum distance or angle of vision
+	get a score of 0, just like candidates which shouldn't be auto-aimed at all. The priorities must already be between 0 and 10,
+	as the shootable registry stores them.
+	The scores are written to memory of the caller, e.g. a scratch array, which must have room for every candidate */
+BERLINBYTEST_API void ScoreAutoAimCandidates(const FAutoAimScoringParameters& InParameters, const FAutoAimCandidateBatch& InCandidates, TArrayView<float> OutScores);
@@ -6,6 +6,7 @@
 #include "GameFramework/Actor.h"
 #include "ProjectileActor.generated.h"
 
+class AProjectilePool;
 class USphereComponent;
 class UProjectileMovementComponent;
 class UStaticMeshComponent;
@@ -19,10 +20,22 @@ class BERLINBYTEST_API AProjectileActor : public AActor
 public:
 	// Sets default values for this actor's properties
 	AProjectileActor();
+	// Places the projectile at the selected location and starts moving it, as if it had just been spawned there by the shooter
+	void ActivateFromPool(AProjectilePool* InPool, const FVector& InLocation, const FRotator& InRotation, AActor* InShooter, float InExpirationTime);
+	// Stops, hides and disables the collision of the projectile so that it can wait in the pool until it is fired again
+	void DeactivateInPool(AProjectilePool* InPool);
+	// Returns the game time at which the projectile must be returned to its pool, or 0 if it never expires
+	float GetPoolExpirationTime() const;
+	// Returns the index of the projectile among the active projectiles of its pool, or INDEX_NONE if it is not flying
+	int32 GetActivePoolIndex() const;
+	// Stores the index of the projectile among the active projectiles of its pool
+	void SetActivePoolIndex(int32 InActivePoolIndex);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	// Called when the projectile is being removed from the game
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	// This function will be called whenever the projectile has a blocking hit with other actor
 	UFUNCTION()
 		void BeginHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent, FVector NormalImpulse, const FHitResult& Hit);
@@ -35,4 +48,11 @@ public:
 		UStaticMeshComponent* MeshComponent;
 	UPROPERTY(VisibleAnywhere, Category = "Movement")
 		UProjectileMovementComponent* ProjectileMovementComponent;
+
+private:
+	// Pool from which the projectile was fired, if it was not spawned on its own
+	UPROPERTY()
+		AProjectilePool* OwningPool;
+	float PoolExpirationTime;
+	int32 ActivePoolIndex;
 };
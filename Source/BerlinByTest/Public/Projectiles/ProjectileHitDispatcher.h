@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "ProjectileHitDispatcher.generated.h"
+
+// Hit of a projectile or an explosion against an actor
+struct FProjectileHit
+{
+	/** Actor that caused the hit, which is the owner of the shooter for projectile actors and hitscan shots.
+		It is null for simulated projectiles */
+	TWeakObjectPtr<AActor> Hitter;
+	TWeakObjectPtr<AActor> Target;
+	FVector Location;
+	FVector Normal;
+	// Whether the target implements the shootable interface
+	bool bIsTargetShootable;
+};
+
+// Called once per frame with every hit queued during it, after the shootables that have been hit have been notified
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnProjectileHitsDispatchedSignature, const TArray<FProjectileHit>& /*Hits*/);
+
+/** Collects the hits of every projectile and explosion of the world during a frame and handles them all at once after physics,
+	instead of each one being handled inside the physics callback that detected it. Whether the class of each hit actor
+	implements the shootable interface is only looked up once. Listeners such as scores, effects or AI reactions can subscribe
+	to the whole batch of hits */
+UCLASS(NotBlueprintable, Transient)
+class BERLINBYTEST_API AProjectileHitDispatcher : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AProjectileHitDispatcher();
+	// Returns the hit dispatcher of the world of the context object, creating it if needed
+	static AProjectileHitDispatcher* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	// Queues a hit, which will be dispatched along with the rest of the hits of this frame
+	static void QueueHit(const UObject* WorldContextObject, AActor* InHitter, AActor* InTarget, const FVector& InLocation, const FVector& InNormal);
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	// Returns true if the class implements the shootable interface, looking it up only the first time
+	bool IsShootableClass(UClass* InClass);
+
+//VARIABLES
+public:
+	// Called once per frame with every hit of the frame
+	FOnProjectileHitsDispatchedSignature OnProjectileHitsDispatched;
+
+private:
+	// Hits queued since the last tick
+	TArray<FProjectileHit> QueuedHits;
+	// Hits being dispatched, swapped with the queued ones every tick so that neither array is reallocated
+	TArray<FProjectileHit> DispatchedHits;
+	// Whether each class that has been hit implements the shootable interface
+	TMap<const UClass*, bool> ShootableClasses;
+};
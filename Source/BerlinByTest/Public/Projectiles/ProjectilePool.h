@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "ProjectilePool.generated.h"
+
+class AProjectileActor;
+
+// What the pool should do when a projectile is requested but all of them are already in use
+UENUM(BlueprintType)
+enum class EProjectilePoolOverflowPolicy : uint8
+{
+	// A new projectile is spawned and added to the pool
+	Grow,
+	// The projectile that has been flying for the longest time is reused
+	RecycleOldest,
+	// No projectile is fired
+	Fail
+};
+
+// Every projectile of a single class held by the pool
+USTRUCT()
+struct FProjectilePoolBucket
+{
+	GENERATED_BODY()
+
+	// Projectiles ready to be fired
+	UPROPERTY()
+		TArray<AProjectileActor*> InactiveProjectiles;
+	/** Projectiles currently flying, in no particular order. Each projectile knows its index in the array,
+		so that returning it to the pool only needs to swap it with the last one */
+	UPROPERTY()
+		TArray<AProjectileActor*> ActiveProjectiles;
+	// How many seconds a projectile of this class flies before being returned to the pool, if it doesn't hit anything
+	float LifeSpanInSeconds;
+};
+
+/** Keeps the projectiles of the world alive between shots, so that firing a projectile activates an existing actor
+	and a hit or the end of its life span deactivates it, instead of spawning and destroying an actor for every shot */
+UCLASS(NotBlueprintable, Transient)
+class BERLINBYTEST_API AProjectilePool : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AProjectilePool();
+	// Returns the projectile pool of the world of the context object, creating it if needed
+	static AProjectilePool* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	// Spawns inactive projectiles of the selected class until the pool holds at least the selected amount of them
+	void Prewarm(TSubclassOf<AProjectileActor> InProjectileClass, int32 InPoolSize);
+	/** Fires a projectile of the selected class from the pool, owned by the shooter until it returns to the pool. If all of them
+		are in use, the overflow policy decides what happens, and null is returned if no projectile could be fired */
+	AProjectileActor* FireProjectile(TSubclassOf<AProjectileActor> InProjectileClass, const FVector& InLocation, const FRotator& InRotation, AActor* InShooter, EProjectilePoolOverflowPolicy InOverflowPolicy);
+	// Deactivates a projectile fired from this pool so that it can be fired again
+	void ReturnProjectile(AProjectileActor* InProjectile);
+	// Returns how many projectiles of the pool are currently flying
+	int32 GetNumActiveProjectiles() const;
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	// Called when the pool is being removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Returns the bucket of the selected projectile class, creating it if needed
+	FProjectilePoolBucket& GetBucket(TSubclassOf<AProjectileActor> InProjectileClass);
+	// Spawns a new projectile which starts deactivated
+	AProjectileActor* SpawnInactiveProjectile(TSubclassOf<AProjectileActor> InProjectileClass);
+	// Removes the active projectile at the selected index, moving the last active projectile of the bucket into its place
+	static void RemoveActiveProjectile(FProjectilePoolBucket& InOutBucket, int32 InActiveIndex);
+
+//VARIABLES
+private:
+	UPROPERTY()
+		TMap<UClass*, FProjectilePoolBucket> Buckets;
+};
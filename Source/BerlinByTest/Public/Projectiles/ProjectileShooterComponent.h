@@ -5,13 +5,147 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "Runtime/Engine/Public/TimerManager.h"
+#include "WorldCollision.h"
+#include "Engine/StreamableManager.h"
+#include "Core/ScratchArray.h"
+#include "Projectiles/ProjectilePool.h"
+#include "Projectiles/ProjectileSpawnEvent.h"
 #include "ProjectileShooterComponent.generated.h"
 
+class AProjectileActor;
+
+// Called whenever the current ammo of a shooter changes
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAmmoChangedSignature, int32, CurrentAmmo, int32, MaximumAmmo);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnAmmoChangedNativeSignature, int32 /*CurrentAmmo*/, int32 /*MaximumAmmo*/);
+// Called whenever a reload cooldown starts, with the world time at which it started and how many seconds it lasts
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnReloadStartedSignature, float, StartTimeInSeconds, float, DurationInSeconds);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnReloadStartedNativeSignature, float /*StartTimeInSeconds*/, float /*DurationInSeconds*/);
+// Called whenever ammo is reloaded, which also ends the reload cooldown that was running, if any
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnReloadCompletedSignature);
+DECLARE_MULTICAST_DELEGATE(FOnReloadCompletedNativeSignature);
+// Called whenever the shooter fires a projectile, with the actor it auto-aimed to, if any
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnShotFiredNativeSignature, const FVector& /*Location*/, const FRotator& /*Rotation*/, const AActor* /*AutoAimedActor*/);
+
+// How the shooter checks that the auto-aim candidates are not occluded by other actors
+UENUM(BlueprintType)
+enum class EAutoAimOcclusionMode : uint8
+{
+	// Candidates are traced on the spot from the highest to the lowest score, until a visible one is found
+	Synchronous,
+	/** Candidates are traced as a single asynchronous batch and the projectile is spawned the next frame,
+		when the results of the traces are available */
+	Asynchronous
+};
+
+// How the projectiles of a shooter are brought into the world
+UENUM(BlueprintType)
+enum class EProjectileDeliveryMode : uint8
+{
+	// A new projectile actor is spawned for every shot and destroyed when it hits something or its life span ends
+	SpawnActor,
+	/** Projectile actors are taken from the projectile pool of the world and returned to it afterwards.
+		Only projectile classes derived from AProjectileActor can be pooled, other classes are spawned instead */
+	PooledActor,
+	/** Projectiles are simulated as plain data by the projectile simulation manager of the world and drawn as instances
+		of a single mesh, which scales to many more projectiles than actors do. Only projectile classes derived from
+		AProjectileActor can be simulated, other classes are spawned instead */
+	Simulated,
+	/** No projectile is brought into the world: every shot is resolved on the spot with a single trace along its direction, and
+		the actor it hits is notified along with the rest of the hits of the frame. If the projectile class derives from
+		AProjectileActor, a tracer with its mesh and speed can be drawn by the projectile simulation manager of the world */
+	Hitscan
+};
+
+// How the ammo of a shooter is reloaded over time
+UENUM(BlueprintType)
+enum class EAmmoRegenerationMode : uint8
+{
+	// A timer reloads a projectile every time the reload cooldown ends
+	Timer,
+	/** Only the time at which the current reload cooldown started is stored, and the reloaded ammo is computed from the world time
+		whenever it is needed. Idle shooters cost nothing and don't use the timer manager at all, which suits many AI shooters.
+		Ammo changes caused by the passing of time are only notified once someone reads or spends the ammo */
+	Timestamp
+};
+
+// How the projectiles of a burst are spread around the direction the burst is aimed at
+UENUM(BlueprintType)
+enum class EProjectileSpreadPattern : uint8
+{
+	// Projectiles are spread evenly from left to right, up to the spread angle on each side
+	Fan,
+	// The first projectile flies straight ahead and the rest of them are spread evenly around it, at the spread angle
+	Ring,
+	/** Projectiles fly in random directions within the spread angle. The directions come from a seed sent along with the shot,
+		so that every machine fires the same ones */
+	RandomCone
+};
+
+// Shootable that could be auto-aimed, along with the score it would get if it was visible
+struct FAutoAimCandidate
+{
+	TWeakObjectPtr<AActor> Actor;
+	FVector Location;
+	float Score;
+};
+
+// Shot waiting for the results of its asynchronous occlusion traces to decide where to aim
+struct FPendingAutoAimShot
+{
+	FVector ProjectileLocation;
+	// Rotation used if no candidate turns out to be visible
+	FRotator ProjectileRotation;
+	// Candidates sorted from the highest to the lowest score, each one with the handle of its trace
+	TArray<FAutoAimCandidate> Candidates;
+	TArray<FTraceHandle> TraceHandles;
+	// Frame in which the traces were requested, as their results are only available from the next one
+	uint64 RequestFrame;
+	// Projectiles fired by the shot and how they are spread around the direction it ends up aimed at
+	int32 NumProjectiles;
+	EProjectileSpreadPattern SpreadPattern;
+	int32 SpreadSeed;
+};
+
+// Shot predicted by the owning client, waiting for the server to process it
+struct FPredictedShot
+{
+	// Sequence number the shot was sent to the server with
+	uint16 Sequence;
+	// Ammo the client spent on the shot
+	int32 NumProjectiles;
+};
+
+/** Ammo of a shooter as the server sees it, sent to the owning client along with the last predicted shot the server has processed,
+	so that the client can spend the ammo of the shots the server hasn't processed yet on top of it */
+USTRUCT()
+struct BERLINBYTEST_API FReplicatedShooterAmmo
+{
+	GENERATED_BODY()
+
+	// Ammo held at the start of the current reload cooldown when using timestamp-based regeneration, or the current ammo otherwise
+	UPROPERTY()
+		int32 Ammo;
+	// Server world time (in seconds) at which the current reload cooldown started
+	UPROPERTY()
+		float ReloadStartTimeInSeconds;
+	// Whether a reload cooldown is running, when using timestamp-based regeneration
+	UPROPERTY()
+		bool bIsRegeneratingAmmo;
+	// Sequence number of the last predicted shot processed by the server
+	UPROPERTY()
+		uint16 LastProcessedShotSequence;
+
+	FReplicatedShooterAmmo();
+};
+
 UCLASS( ClassGroup=(Projectiles), meta=(BlueprintSpawnableComponent) )
 class BERLINBYTEST_API UProjectileShooterComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
+	// The auto-aim manager hands the targets it finds to the shooters that use it
+	friend class AAutoAimManager;
+
 //FUNCTIONS
 public:	
 	// Sets default values for this component's properties
@@ -19,6 +153,17 @@ public:
 	// Shoots a projectile
 	UFUNCTION(BlueprintCallable)
 		bool Shoot();
+	/** Shoots several projectiles at once, spending an ammo for each one of them. Auto-aim is resolved once for the whole burst,
+		and its projectiles are spread around the aimed direction with the selected pattern and brought into the world together.
+		If there is not enough ammo for the whole burst, only the projectiles that can be afforded are shot */
+	UFUNCTION(BlueprintCallable)
+		bool ShootBurst(int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern);
+	// Shoots a burst with the volley size and spread pattern of the component
+	UFUNCTION(BlueprintCallable)
+		bool ShootVolley();
+	// Returns how many seconds are left until the fire rate allows shooting again
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+		float GetRemainingFireCooldownInSeconds() const;
 	// Return the current available amount of projectiles to shoot
 	UFUNCTION(BlueprintPure, BlueprintCallable)
 		int32 GetCurrentAmmo() const;
@@ -34,19 +179,127 @@ public:
 	// Returns how many seconds are left until the next projectile is added automatically to the inventory
 	UFUNCTION(BlueprintPure, BlueprintCallable)
 		float GetRemainingReloadCooldownInSeconds() const;
+	// Returns true if a reload cooldown is currently running
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+		bool IsReloading() const;
+	/** Returns the world time (in seconds) at which the current reload cooldown started. Along with the reload cooldown,
+		it lets widgets animate the cooldown on their own instead of asking for the remaining time every frame */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+		float GetReloadStartTimeInSeconds() const;
+	/** Returns the actor currently tracked by auto-aim, if any. It is only kept up to date while target tracking is enabled,
+		and every frame if the target is tracked every frame, which makes it suitable to highlight the target */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+		AActor* GetTrackedAutoAimTarget() const;
+	// Replicates the ammo to the owning client
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	// Stores the ammo of the server in the replicated ammo before it is sent
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+#if WITH_DEV_AUTOMATION_TESTS
+	// Returns the actor auto-aim would choose on its own, without target tracking, so that automation tests can check and time it
+	const AActor* GetCenteredShootableActorForTesting() const;
+	// Returns how many shootables auto-aim would score, ignoring occlusion
+	int32 GetNumAutoAimCandidatesForTesting() const;
+	// Returns the score the scalar auto-aim scoring gives to a candidate
+	float GetAutoAimScoreForTesting(float InPriority, float InDistance, float InCosineOfVisionAngle, float InCosineOfMaximumVisionAngle) const;
+#endif
 
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	// Called when the component is being removed from the game
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// Called every frame while tracking the auto-aim target or while there are shots waiting for their occlusion traces
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 private:
 	// Sets a timer to reload a projectile
 	UFUNCTION()
 		void StartReload();
+	// Changes the current ammo, notifying the listeners if it is different
+	void SetCurrentAmmo(int32 InCurrentAmmo);
+	// Spends the ammo of the projectiles of a shot and starts a reload cooldown
+	void SpendAmmo(int32 InAmountOfAmmoToSpend = 1);
+	// Applies the ammo replicated by the server
+	UFUNCTION()
+		void OnRep_ServerAmmo();
+	/** Takes the ammo of the server as the current one and spends on top of it the ammo of the predicted shots
+		the server hadn't processed yet, unless the server had processed fewer shots than in the ammo applied last */
+	void ApplyServerAmmo(const FReplicatedShooterAmmo& InServerAmmo);
+	// Returns the ammo of the shooter as it is sent to the owning client
+	FReplicatedShooterAmmo GetServerAmmo() const;
+	/** Computes the ammo the shooter has at the current world time, along with the time at which its reload cooldown started.
+		Without timestamp-based regeneration, it simply returns the current ammo */
+	int32 GetRegeneratedAmmo(float& OutReloadStartTimeInSeconds) const;
+	// Stores the ammo reloaded since the last time it was stored, when using timestamp-based regeneration
+	void UpdateRegeneratedAmmo();
 	// Returns the current world timer manager
 	FTimerManager& GetTimerManager(bool& bOutIsTimerManagerValid) const;
 	// Computes the actor which should be auto-aimed, if any
 	const AActor* GetCenteredShootableActor() const;
+	/** Gathers the shootables that could be auto-aimed, ignoring occlusion, sorted from the highest to the lowest score.
+		They are allocated in the scratch memory of the caller, which has to take a mark first.
+		Returns false if the owner can't auto-aim at all */
+	bool GetAutoAimCandidates(FVector& OutOwnerLocation, TScratchArray<FAutoAimCandidate>& OutCandidates) const;
+	// Returns true if the trace from the owner to the candidate location hits the candidate before any other actor
+	bool IsAutoAimCandidateVisible(const FVector& InOwnerLocation, const AActor* InCandidate, const FVector& InCandidateLocation) const;
+	/** Returns the actor to auto-aim to when shooting. If target tracking is enabled, the tracked target and its runners-up
+		are rechecked before evaluating every candidate again */
+	const AActor* ResolveAutoAimTarget();
+	// Returns true if the tracked targets are too old or the owner has moved or turned too much since they were evaluated
+	bool ShouldRefreshTrackedTargets() const;
+	// Evaluates every candidate again to find the tracked target and its runners-up
+	void RefreshTrackedTargets();
+	// Returns true if the actor is still within the maximum distance and angle of vision and is not occluded
+	bool IsAutoAimTargetStillValid(const AActor* InTarget) const;
+	// Stores the auto-aim target found this frame by the auto-aim manager
+	void SetParallelAutoAimTarget(AActor* InTarget);
+	/** Returns the auto-aim target found by the auto-aim manager, as long as it was found this frame or the previous one.
+		Otherwise the target is found on the spot */
+	const AActor* GetParallelAutoAimTarget() const;
+	// Loads the soft projectile class asynchronously, unless it is not set or already loaded
+	void LoadProjectileClass();
+	/** Has the projectiles of the pool ready beforehand, so that shooting never needs to spawn them.
+		Called once the projectile class has been loaded */
+	void PrewarmProjectilePool();
+	// Enables ticking only while it is needed
+	void UpdateComponentTickEnabled();
+	// Returns how many of the sorted candidates are allowed to be traced for a single shot
+	int32 GetNumTraceableCandidates(int32 InNumCandidates) const;
+	// Requests the asynchronous occlusion traces of a shot, whose projectiles will be spawned once their results are available
+	void QueueAsyncAutoAimShot(const FVector& InProjectileLocation, const FRotator& InProjectileRotation, int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern, int32 InSpreadSeed);
+	// Spawns the projectiles of a shot whose asynchronous occlusion traces have finished
+	void ResolvePendingAutoAimShot(const FPendingAutoAimShot& InPendingShot);
+	/** Spawns the projectiles of a shot spread around the auto-aimed actor, if there is one, and sends the shot to the other machines
+		of a networked game. Returns how many projectiles could be brought into the world */
+	int32 SpawnProjectiles(const FVector& InProjectileLocation, const FRotator& InProjectileRotation, const AActor* InAutoAimedActor, int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern, int32 InSpreadSeed);
+	/** Brings projectiles into the world with the delivery mode of the shooter, in order, until one of them can't be.
+		Returns how many of them were brought into the world */
+	int32 DeliverProjectiles(const FVector& InProjectileLocation, TArrayView<const FRotator> InProjectileRotations);
+	/** Traces a hitscan shot along its direction, queues the hit of the actor it hits, if any, and draws its tracer.
+		Returns false if the shot couldn't be traced */
+	bool TraceHitscanShot(const FVector& InProjectileLocation, const FRotator& InProjectileRotation, TSubclassOf<AProjectileActor> InProjectileActorClass);
+	// Computes the direction of every projectile of a shot aimed at the given rotation
+	void GetSpreadRotations(const FRotator& InAimRotation, int32 InNumProjectiles, EProjectileSpreadPattern InSpreadPattern, int32 InSpreadSeed, TArray<FRotator, TInlineAllocator<16>>& OutRotations) const;
+	/** Sends a shot fired on this machine to the other ones: owning clients ask the server to fire it,
+		numbering it to know when the server has processed it, and the server tells the rest of the clients to simulate it */
+	void ReplicateShot(const FProjectileSpawnEvent& InSpawnEvent);
+	/** Fires the projectiles predicted by the owning client, as long as the server agrees that they could be fired:
+		the server has the final say over the ammo, the fire rate and where the projectiles come from */
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerShoot(const FProjectileSpawnEvent& InSpawnEvent, uint16 InShotSequence);
+	// Gives the owning client the ammo of the server back after a predicted shot is rejected
+	UFUNCTION(Client, Reliable)
+		void ClientShotRejected(const FReplicatedShooterAmmo& InServerAmmo);
+	// Simulates the projectile fired by the server on the clients that don't own the shooter
+	UFUNCTION(NetMulticast, Unreliable)
+		void MulticastProjectileSpawned(const FProjectileSpawnEvent& InSpawnEvent);
+	// Returns the world time of the server, as known by this machine
+	float GetServerWorldTimeSeconds() const;
+	// Returns the class of the projectiles spawned, loading the soft projectile class right away if it hasn't been loaded yet
+	UClass* GetSpawnedProjectileClass() const;
+	/** Returns the projectile class if it derives from AProjectileActor, which is needed to pool or simulate its projectiles,
+		or null otherwise */
+	TSubclassOf<AProjectileActor> GetProjectileActorClass() const;
 	/** Generates a score which dictates the actor that should be auto-aimed depending on the angle,
 		distance and priority of the actor */
 	float GetAutoAimScore(float InPriority, float InDistance, float InCosineOfVisionAngle, float InCosineOfMaximumVisionAngle) const;
@@ -62,9 +315,47 @@ public:
 	// How many seconds will it take for a projectile to be automatically reloaded after being shot
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile Shooter|Configuration|Ammo")
 		float ReloadCooldownInSeconds;
-	// The projectiles spawned will be of this class
+	// How the ammo is reloaded over time
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Ammo")
+		EAmmoRegenerationMode AmmoRegenerationMode;
+	// The projectiles spawned will be of this class, unless a soft projectile class is set
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Ammo")
 		TSubclassOf<AActor> ProjectileClass;
+	/** If set, the projectiles spawned will be of this class instead. It is loaded asynchronously when the game starts instead of
+		along with the shooter, and shots fired before it has finished loading load it on the spot */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Ammo")
+		TSoftClassPtr<AActor> SoftProjectileClass;
+	// Maximum distance (in unreal units) at which hitscan shots can hit an actor
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Projectiles|Hitscan")
+		float HitscanRange;
+	// Whether hitscan shots draw a tracer flying from the shooter to whatever they hit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Projectiles|Hitscan")
+		bool bDrawHitscanTracers;
+	/** Minimum time (in seconds) between two shots, which limits the fire rate of the shooter. Shooting before it has passed
+		does nothing, and the server rejects shots predicted by the owning client that break it.
+		If lower or equal to 0, the fire rate is only limited by the ammo */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile Shooter|Configuration|Firing")
+		float MinimumSecondsBetweenShots;
+	/** Maximum angle (in degrees) between the direction a burst is aimed at and the direction of each one of its projectiles.
+		Only the spread pattern is sent along with the shots, so every machine has to use the same angle */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Firing")
+		float SpreadAngle;
+	// How many projectiles are shot by a volley
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile Shooter|Configuration|Firing")
+		int32 VolleySize;
+	// How the projectiles of a volley are spread
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Projectile Shooter|Configuration|Firing")
+		EProjectileSpreadPattern VolleySpreadPattern;
+	// How the projectiles are brought into the world when shooting
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Projectiles")
+		EProjectileDeliveryMode ProjectileDeliveryMode;
+	/** How many projectiles of the projectile class will be ready in the projectile pool when the game starts.
+		The pool is shared by every shooter in the world, and it keeps the largest size requested */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Projectiles")
+		int32 ProjectilePoolSize;
+	// What happens when shooting while every pooled projectile is already flying
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Projectiles")
+		EProjectilePoolOverflowPolicy ProjectilePoolOverflowPolicy;
 	/** How much will the auto-aim priority of the actor weight on the auto-aim decision.
 		E.g., if a priority weight of 1 is selected, distance weight of 0 and focus weight of 3,
 		the priority will weight a 25% in the decision of who to auto-aim to */
@@ -89,12 +380,119 @@ public:
 	// The maximum angle (in degrees) from the center of the screen at which the projectiles can auto-aim
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim")
 		float MaximumVisionAngle;
+	// How occlusion is checked for the actors that could be auto-aimed
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim")
+		EAutoAimOcclusionMode AutoAimOcclusionMode;
+	/** Maximum amount of occlusion traces that will be done for a single shot, starting from the best candidate.
+		If lower or equal to 0, every candidate can be traced. Otherwise, when every traced candidate is occluded the shot
+		is not auto-aimed, even if a candidate with a lower score is visible */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim")
+		int32 MaximumOcclusionTracesPerShot;
+	/** Whether the auto-aim candidates are scored several at a time with vectorized math.
+		Otherwise they are scored one by one, which is slower when there are many candidates */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim")
+		bool bUseBatchAutoAimScoring;
+	/** Whether the auto-aim target is found every frame by the auto-aim manager of the world, along with the target of every
+		other shooter that uses it, spread across worker threads. Shooting then uses the target found this frame, which suits
+		many AI shooters. The occlusion mode and target tracking are not used by these shooters */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim")
+		bool bUseParallelAutoAim;
+	/** Whether the auto-aim target found when shooting is kept for the next shots, along with a few runners-up.
+		While it is kept, shooting only checks that the target is still valid and visible, and the target is only
+		evaluated again when the refresh interval ends or the owner moves or turns past the thresholds.
+		Off by default, as a kept target can differ from the best one until it is refreshed.
+		Tracking is not used by the asynchronous occlusion mode */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim|Tracking")
+		bool bUseAutoAimTargetTracking;
+	// Whether the tracked target is refreshed every frame instead of only when shooting, e.g. to highlight it
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim|Tracking")
+		bool bTrackAutoAimTargetEveryFrame;
+	// How many candidates with the next best scores are kept in case the tracked target stops being valid
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim|Tracking")
+		int32 NumAutoAimRunnersUp;
+	// Maximum seconds the tracked targets are kept before being evaluated again
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim|Tracking")
+		float AutoAimRefreshIntervalInSeconds;
+	// Distance (in unreal units) the owner has to move for the tracked targets to be evaluated again
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim|Tracking")
+		float AutoAimRefreshDistanceThreshold;
+	// Angle (in degrees) the owner has to turn its view for the tracked targets to be evaluated again
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Auto Aim|Tracking")
+		float AutoAimRefreshAngleThreshold;
+
+	/** Maximum distance (in unreal units) between the origin of a shot predicted by the owning client and the owner on the server.
+		Shots fired from further away are rejected by the server */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Network")
+		float MaximumShotOriginError;
+	/** How many seconds earlier than the fire rate allows a shot predicted by the owning client can reach the server,
+		as shots fired at the right rate may arrive closer together because of network jitter. Earlier shots are rejected */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Network")
+		float FireRateToleranceInSeconds;
+	/** Maximum time (in seconds) a projectile received from the server is moved forward along its path,
+		to make up for the time it took to arrive */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Configuration|Network")
+		float MaximumShotFastForwardInSeconds;
+
+	// Called whenever the current ammo changes
+	UPROPERTY(BlueprintAssignable, Category = "Projectile Shooter|Events")
+		FOnAmmoChangedSignature OnAmmoChanged;
+	FOnAmmoChangedNativeSignature OnAmmoChangedNative;
+	// Called whenever a reload cooldown starts
+	UPROPERTY(BlueprintAssignable, Category = "Projectile Shooter|Events")
+		FOnReloadStartedSignature OnReloadStarted;
+	FOnReloadStartedNativeSignature OnReloadStartedNative;
+	// Called whenever ammo is reloaded
+	UPROPERTY(BlueprintAssignable, Category = "Projectile Shooter|Events")
+		FOnReloadCompletedSignature OnReloadCompleted;
+	FOnReloadCompletedNativeSignature OnReloadCompletedNative;
+	// Called whenever a projectile is fired by this shooter, but not when it is fired on behalf of a remote one
+	FOnShotFiredNativeSignature OnShotFiredNative;
 
 protected:
-	// Number of projectiles held at the moment
+	/** Number of projectiles held at the moment. With timestamp-based regeneration, it is the amount held at the start of
+		the current reload cooldown, and GetCurrentAmmo should be used instead */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Projectile Shooter|Readables")
 		int32 CurrentAmmo;
+	// Ammo of the server, which is only replicated to the owning client
+	UPROPERTY(ReplicatedUsing = OnRep_ServerAmmo)
+		FReplicatedShooterAmmo ServerAmmo;
 	// Timer handle used for the reload cooldown
 	UPROPERTY(BlueprintReadOnly, Category = "Projectile Shooter|Readables")
 		FTimerHandle ReloadTimerHandle;
+	// World time (in seconds) at which the current reload cooldown started
+	UPROPERTY(BlueprintReadOnly, Category = "Projectile Shooter|Readables")
+		float ReloadStartTimeInSeconds;
+	// Whether a reload cooldown is running, when using timestamp-based regeneration
+	UPROPERTY(BlueprintReadOnly, Category = "Projectile Shooter|Readables")
+		bool bIsRegeneratingAmmo;
+	// World time (in seconds) from which the fire rate allows shooting again
+	UPROPERTY(BlueprintReadOnly, Category = "Projectile Shooter|Readables")
+		float NextShotTimeInSeconds;
+
+private:
+	// Shots waiting for the results of their asynchronous occlusion traces
+	TArray<FPendingAutoAimShot> PendingAutoAimShots;
+	// Best visible auto-aim target found the last time the tracked targets were refreshed
+	TWeakObjectPtr<AActor> TrackedAutoAimTarget;
+	// Candidates with the next best scores, from the highest to the lowest one, whose visibility has not been checked yet
+	TArray<TWeakObjectPtr<AActor>> AutoAimRunnersUp;
+	// Whether the tracked targets have been refreshed at least once
+	bool bHasTrackedAutoAimTargets;
+	// State of the owner the last time the tracked targets were refreshed
+	float LastAutoAimRefreshTime;
+	FVector LastAutoAimRefreshLocation;
+	FVector LastAutoAimRefreshForwardVector;
+	// Keeps the projectile class loaded while the shooter is playing
+	TSharedPtr<FStreamableHandle> ProjectileClassHandle;
+	// Auto-aim target found by the auto-aim manager, along with the frame in which it was found
+	TWeakObjectPtr<AActor> ParallelAutoAimTarget;
+	uint64 ParallelAutoAimFrame;
+	// Sequence number of the last shot predicted by the owning client
+	uint16 LastPredictedShotSequence;
+	// Sequence number of the last predicted shot the server had processed in the ammo applied last by the owning client
+	uint16 LastAcknowledgedShotSequence;
+	// Predicted shots the server hadn't processed yet in the ammo applied last, from the oldest to the newest
+	TArray<FPredictedShot> PredictedShots;
+	// Sequence number of the last predicted shot processed by the server
+	uint16 LastProcessedShotSequence;
 };
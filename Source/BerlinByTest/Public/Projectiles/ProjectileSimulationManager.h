@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "CollisionQueryParams.h"
+#include "ProjectileSimulationManager.generated.h"
+
+class AProjectileActor;
+class UInstancedStaticMeshComponent;
+
+/** Every simulated projectile of a single class, stored as separate arrays for each attribute.
+	Index i of every array belongs to the same projectile, which is drawn by instance i of the instanced mesh */
+USTRUCT()
+struct FSimulatedProjectileBatch
+{
+	GENERATED_BODY()
+
+	// Draws every projectile of the batch
+	UPROPERTY()
+		UInstancedStaticMeshComponent* InstancedMeshComponent;
+	// Transform of the mesh relative to the projectile location, taken from the projectile class
+	FTransform MeshRelativeTransform;
+	// Settings of the projectile class
+	FName CollisionProfileName;
+	float CollisionRadius;
+	float InitialSpeed;
+	float GravityZ;
+	float LifeSpanInSeconds;
+	/** Whether the projectiles of the batch are only drawn, such as the tracers of hitscan shots. They fly straight without sweeping,
+		and each one of them expires after its own life span */
+	bool bIsVisualOnly;
+	// State of each projectile
+	TArray<FVector> Locations;
+	TArray<FVector> Velocities;
+	TArray<float> RemainingLifeSpans;
+	// Parameters of the sweep of each projectile, which ignore the actors that fired it
+	TArray<FCollisionQueryParams> SweepQueryParams;
+	// Sweep results of the current frame, kept between frames to avoid reallocating them
+	TArray<FHitResult> SweepHits;
+	TArray<bool> SweepHasHit;
+};
+
+/** Simulates projectiles as plain data instead of actors: every projectile of the world is moved in a single tick,
+	their hits are detected with a batch of sphere sweeps and they are drawn with one instanced mesh per projectile class.
+	The collision, mesh, speed, gravity and life span of the projectiles are taken from the defaults of their class */
+UCLASS(config=Game, NotBlueprintable, Transient)
+class BERLINBYTEST_API AProjectileSimulationManager : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AProjectileSimulationManager();
+	// Returns the simulation manager of the world of the context object, creating it if needed
+	static AProjectileSimulationManager* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	/** Starts simulating a projectile of the selected class, returning false if it couldn't be fired.
+		The projectile never hits the shooter that fired it, nor the owner or instigator of the shooter */
+	bool FireProjectile(TSubclassOf<AProjectileActor> InProjectileClass, const FVector& InLocation, const FRotator& InRotation, AActor* InShooter);
+	/** Starts drawing a tracer with the mesh and speed of the selected projectile class, which flies straight for the selected
+		distance without hitting anything. Returns false if it couldn't be fired */
+	bool FireTracer(TSubclassOf<AProjectileActor> InProjectileClass, const FVector& InLocation, const FRotator& InRotation, float InDistance);
+	// Returns how many projectiles are currently being simulated
+	int32 GetNumSimulatedProjectiles() const;
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	// Called when the manager is being removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Returns the batch of projectiles or tracers of the selected projectile class, creating it if needed
+	FSimulatedProjectileBatch* GetBatch(TSubclassOf<AProjectileActor> InProjectileClass, bool bInIsVisualOnly = false);
+	// Moves every projectile of the batch, removing the expired ones and queuing the hits of the ones that hit an actor
+	void SimulateBatch(FSimulatedProjectileBatch& InOutBatch, float InDeltaSeconds);
+	// Removes a projectile from the batch, moving the last one into its place
+	void RemoveProjectile(FSimulatedProjectileBatch& InOutBatch, int32 InProjectileIndex);
+	// Updates the instanced mesh of the batch to match its projectiles
+	void UpdateBatchInstances(FSimulatedProjectileBatch& InOutBatch);
+
+//VARIABLES
+public:
+	/** Whether the sweeps of the projectiles are spread across worker threads.
+		The physics scene is only read during the sweeps, and they happen before physics are simulated */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Projectile Simulation|Configuration")
+		bool bUseParallelSweeps;
+	// Minimum amount of projectiles in a batch for its sweeps to be spread across worker threads
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Projectile Simulation|Configuration")
+		int32 MinimumProjectilesForParallelSweeps;
+
+private:
+	UPROPERTY()
+		TMap<UClass*, FSimulatedProjectileBatch> Batches;
+	// Tracers are kept apart from the projectiles of the same class, as they are never swept
+	UPROPERTY()
+		TMap<UClass*, FSimulatedProjectileBatch> TracerBatches;
+};
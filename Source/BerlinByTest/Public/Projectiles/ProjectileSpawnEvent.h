@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "ProjectileSpawnEvent.generated.h"
+
+/** Everything a remote machine needs to fire the same projectile as the shooter did: projectiles fly in a straight line,
+	so their origin, direction and the time at which they were fired are enough to simulate them locally.
+	The direction is sent as a quantized yaw and pitch, which takes 32 bits instead of the 96 bits of a vector */
+USTRUCT()
+struct BERLINBYTEST_API FProjectileSpawnEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FVector_NetQuantize Origin;
+	UPROPERTY()
+		uint16 QuantizedYaw;
+	UPROPERTY()
+		uint16 QuantizedPitch;
+	// Server world time (in seconds) at which the projectile was fired
+	UPROPERTY()
+		float ServerTimeInSeconds;
+	// Actor auto-aimed by the shot, if any, which is sent as its network id
+	UPROPERTY()
+		AActor* Target;
+	/** How many projectiles the burst of the shot was made of. The projectiles of a burst are spread around the direction of the shot
+		with its spread pattern and seed, so that every machine computes the same directions without receiving them */
+	UPROPERTY()
+		uint8 BurstSize;
+	/** How many projectiles of the burst were fired, which are always the first ones. There may be fewer than in the burst
+		if the shooter couldn't bring all of them into the world or couldn't afford them */
+	UPROPERTY()
+		uint8 NumProjectiles;
+	UPROPERTY()
+		uint8 SpreadPattern;
+	UPROPERTY()
+		uint16 SpreadSeed;
+
+	FProjectileSpawnEvent();
+	// Creates the event of a projectile fired from the origin with the given rotation, whose roll is discarded
+	FProjectileSpawnEvent(const FVector& InOrigin, const FRotator& InRotation, float InServerTimeInSeconds, AActor* InTarget);
+	// Returns the rotation of the projectile, once unquantized
+	FRotator GetRotation() const;
+	// Writes or reads the event with as few bits as possible
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FProjectileSpawnEvent> : public TStructOpsTypeTraitsBase2<FProjectileSpawnEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "BerlinByTestCharacter.h"
+#include "SessionRecorder.generated.h"
+
+class APlayerController;
+
+/** Records the input of the player character every frame, along with the auto-aim decisions of its shots and the random seed,
+	into a compact binary file, and replays it on the same map so that the exact same session can be run on different builds.
+	While replaying, every frame lasts as long as it lasted when it was recorded, regardless of how long it takes to run it,
+	so it can be run headless with -nullrhi. Once the replay ends, a report of the time each frame took and the state of the
+	character is written to Saved/Sessions and the game exits.
+	Sessions are recorded with -BBTRecord=File and replayed with -BBTReplay=File, where relative files are in Saved/Sessions.
+	The random seed can be chosen with -BBTSeed=Seed */
+UCLASS(NotBlueprintable, Transient)
+class BERLINBYTEST_API ASessionRecorder : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	ASessionRecorder();
+	// Returns the session recorder of the world of the context object, creating it if needed
+	static ASessionRecorder* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	// Starts recording or replaying the session of the player controller if the command line asks for it, only once per run
+	static void StartFromCommandLine(APlayerController* InPlayerController);
+	// Starts recording the input of the player, returning false if it is already recording or replaying
+	bool StartRecording(const FString& InFilePath);
+	// Stops recording and writes the recorded session to its file
+	void StopRecording();
+	// Loads a recorded session and starts replaying it, returning false if the file couldn't be loaded
+	bool StartReplay(const FString& InFilePath);
+	// Returns true while recording a session
+	bool IsRecording() const;
+	// Returns true while replaying a session
+	bool IsReplaying() const;
+	// Listens to the shots of the character, so that their auto-aim decisions are recorded or checked
+	void BindCharacter(ABerlinByTestCharacter* InCharacter);
+	// Adds the input given to the character this frame to the recorded session
+	void RecordInputFrame(ABerlinByTestCharacter* InCharacter, const FCharacterInputFrame& InInputFrame, float InDeltaSeconds);
+	// Gives the character the recorded input of the current frame, ending the replay once there are no frames left
+	void ReplayInputFrame(ABerlinByTestCharacter* InCharacter, float InDeltaSeconds);
+
+protected:
+	// Called when the recorder is being removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Frame of a recorded session
+	struct FRecordedFrame
+	{
+		float DeltaSeconds;
+		FCharacterInputFrame Input;
+		// Names of the actors auto-aimed by the shots of the frame, or None for the shots that weren't auto-aimed
+		TArray<FName> AutoAimTargets;
+	};
+	// State of the replayed session after each frame, written to the replay report
+	struct FReplayedFrame
+	{
+		float DeltaSeconds;
+		double FrameTimeInSeconds;
+		FVector CharacterLocation;
+		float ControlYaw;
+		int32 CurrentAmmo;
+	};
+	// Writes or reads a frame, storing only the input that isn't zero
+	static void SerializeFrame(FArchive& Ar, FRecordedFrame& InOutFrame);
+	// Returns the file of a session, which is in Saved/Sessions if it is relative
+	static FString GetSessionFilePath(const FString& InFilePath);
+	// Returns the name of the current map, without the prefix added to it when playing in the editor
+	FString GetMapName() const;
+	// Initializes every random number generator with the seed of the session
+	void SetRandomSeed(int32 InRandomSeed);
+	// Called whenever the character fires a projectile
+	void OnShotFired(const FVector& InLocation, const FRotator& InRotation, const AActor* InAutoAimedActor);
+	// Makes the next frame of the engine last as long as the next recorded frame
+	void SetNextFrameDeltaSeconds() const;
+	// Writes the replay report and exits the game
+	void FinishReplay();
+
+//VARIABLES
+private:
+	enum class ESessionRecorderState : uint8
+	{
+		Idle,
+		Recording,
+		Replaying
+	};
+	ESessionRecorderState State;
+	FString SessionFilePath;
+	int32 RandomSeed;
+	// Encoded frames recorded so far
+	TArray<uint8> RecordedFrameData;
+	int32 NumRecordedFrames;
+	// Frames of the replayed session, along with the index of the next one to replay
+	TArray<FRecordedFrame> ReplayFrames;
+	int32 NextReplayFrameIndex;
+	TArray<FReplayedFrame> ReplayedFrames;
+	double LastReplayFrameTime;
+	// How many shots were auto-aimed to a different actor than the recorded one
+	int32 NumAutoAimMismatches;
+	// Names of the actors auto-aimed since the last frame was recorded or replayed
+	TArray<FName> CurrentAutoAimTargets;
+	TWeakObjectPtr<ABerlinByTestCharacter> BoundCharacter;
+	FDelegateHandle ShotFiredHandle;
+};
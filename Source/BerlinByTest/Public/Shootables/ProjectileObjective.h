@@ -19,15 +19,25 @@ public:
 	// Sets default values for this actor's properties
 	AProjectileObjective();
 	virtual float GetAutoAimPriority_Implementation() const override;
+	// Changes the auto-aim priority, letting the shootable registry know about it
+	UFUNCTION(BlueprintSetter)
+		void SetAutoAimPriority(float InAutoAimPriority);
+#if WITH_EDITOR
+	// Lets the shootable registry know about priorities changed in the editor while playing
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	// Called when the actor is being removed from the game
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 //VARIABLES
 public:
-	// This value must be between 0 and 10 (it will be clamped to that range in the calculations otherwise)
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Projectile Objective|Shootable")
+	/** This value must be between 0 and 10 (it will be clamped to that range in the calculations otherwise).
+		It is stored by the shootable registry, so it has to be changed with SetAutoAimPriority once the game has started */
+	UPROPERTY(BlueprintReadWrite, BlueprintSetter = SetAutoAimPriority, EditAnywhere, Category = "Projectile Objective|Shootable")
 		float AutoAimPriority;
 	UPROPERTY(VisibleDefaultsOnly, Category = "Projectile Objective")
 		UStaticMeshComponent* MeshComponent;
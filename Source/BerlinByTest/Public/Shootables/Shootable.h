@@ -26,7 +26,9 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Projectiles")
 		void ProjectileHit();
 	/** This function is used to get the auto-aim priority of this actor.
-		It must return a value between 0 and 10, and has to be implemented in every actor that implements this interface */
+		It must return a value between 0 and 10, and has to be implemented in every actor that implements this interface.
+		The shootable registry reads it once when the actor is registered, so AShootableRegistry::NotifyShootablePriorityChanged
+		must be called whenever the value returned changes, or auto-aim will keep using the old one */
 	UFUNCTION(BlueprintNativeEvent, Category = "Projectiles")
 		float GetAutoAimPriority() const;
 	virtual float GetAutoAimPriority_Implementation() const;
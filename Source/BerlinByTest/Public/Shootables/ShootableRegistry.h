@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Core/ScratchArray.h"
+#include "ShootableRegistry.generated.h"
+
+// Shootable actor found by a query to the shootable registry
+struct FShootableQueryResult
+{
+	AActor* Actor;
+	FVector Location;
+	float Distance;
+	// Cosine of the angle between the query forward vector and the vector from the query origin to the actor
+	float CosineToForward;
+	// Auto-aim priority stored by the registry, between 0 and 10
+	float AutoAimPriority;
+};
+
+/** Keeps track of every actor in the world that implements the shootable interface, stored in a uniform grid,
+	so that auto-aim can query the shootables inside a cone without iterating over every actor of the world.
+	The auto-aim priority of each shootable is stored along with it, so that scoring doesn't have to call the interface,
+	which might run Blueprint code, for every candidate of every shot. Shootables whose priority changes have to notify it */
+UCLASS(config=Game, NotBlueprintable, Transient)
+class BERLINBYTEST_API AShootableRegistry : public AInfo
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this actor's properties
+	AShootableRegistry();
+	// Returns the registry of the world of the context object, creating it if needed
+	static AShootableRegistry* Get(const UObject* WorldContextObject, bool bCreateIfMissing = true);
+	// Adds an actor to the registry, as long as it implements the shootable interface
+	UFUNCTION(BlueprintCallable, Category = "Shootables", meta = (DefaultToSelf = "InShootableActor"))
+		static void RegisterShootable(AActor* InShootableActor);
+	// Removes an actor from the registry
+	UFUNCTION(BlueprintCallable, Category = "Shootables", meta = (DefaultToSelf = "InShootableActor"))
+		static void UnregisterShootable(AActor* InShootableActor);
+	// Reads the auto-aim priority of a registered shootable again. Must be called whenever it changes
+	UFUNCTION(BlueprintCallable, Category = "Shootables", meta = (DefaultToSelf = "InShootableActor"))
+		static void NotifyShootablePriorityChanged(AActor* InShootableActor);
+	// Returns the auto-aim priority stored for a shootable, or 0 if it isn't registered
+	float GetShootablePriority(const AActor* InShootableActor) const;
+	/** Gathers every registered shootable which is inside the cone defined by the origin, the normalized forward vector
+		and the cosine of the half angle of the cone. If the maximum distance is lower or equal to 0, the distance is not limited.
+		The results are allocated in the scratch memory of the caller, which has to take a mark first */
+	void GetShootablesInCone(const FVector& InOrigin, const FVector& InForwardVector, float InCosineOfMaximumAngle, float InMaximumDistance, TScratchArray<FShootableQueryResult>& OutShootables) const;
+	/** Visits every registered shootable stored in a grid cell that intersects the cone, along with its auto-aim priority,
+		without checking the shootables themselves. Used when the caller tests the shootables against the cone on its own,
+		for example in batches */
+	void ForEachShootableNearCone(const FVector& InOrigin, const FVector& InForwardVector, float InCosineOfMaximumAngle, float InMaximumDistance, TFunctionRef<void(AActor*, float)> InVisitor) const;
+	// Visits every registered shootable, along with its auto-aim priority
+	void ForEachShootable(TFunctionRef<void(AActor*, float)> InVisitor) const;
+	// Returns how many shootables are currently registered
+	int32 GetNumShootables() const;
+	// Called every frame
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	// Called once all the components of the registry have been initialized
+	virtual void PostInitializeComponents() override;
+	// Called when the registry is being removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Adds an actor to the grid if it hasn't been added before
+	void AddShootable(AActor* InShootableActor);
+	// Removes an actor from the grid if it has been added before
+	void RemoveShootable(AActor* InShootableActor);
+	// Called whenever an actor is spawned in the world, so that Blueprint shootables get registered as well
+	void OnActorSpawned(AActor* InSpawnedActor);
+	// Called whenever a registered shootable leaves the game
+	UFUNCTION()
+		void OnShootableEndPlay(AActor* InActor, EEndPlayReason::Type InEndPlayReason);
+	// Returns the grid cell which contains the given location
+	FIntVector GetCell(const FVector& InLocation) const;
+	// Adds the entry to the list of entries of its current cell
+	void AddEntryToCell(int32 InEntryIndex);
+	// Removes the entry from the list of entries of its current cell
+	void RemoveEntryFromCell(int32 InEntryIndex);
+	// Returns the auto-aim priority of a shootable, clamped between 0 and 10
+	static float ReadShootablePriority(AActor* InShootableActor);
+	// Checks a registered shootable against the query cone, adding it to the results if it is inside it
+	void TestShootableAgainstCone(AActor* InShootableActor, float InAutoAimPriority, const FVector& InOrigin, const FVector& InForwardVector, float InCosineOfMaximumAngle, float InMaximumDistance, TScratchArray<FShootableQueryResult>& OutShootables) const;
+
+//VARIABLES
+public:
+	/** Size (in unreal units) of the side of each cell of the grid.
+		It should be around the usual auto-aim distance, so that queries only need to visit a few cells */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Shootable Registry|Configuration")
+		float CellSize;
+
+private:
+	struct FShootableEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		// Cell in which the shootable was the last time the grid was updated
+		FIntVector Cell;
+		// Only shootables that can move need to be relocated in the grid every frame
+		bool bIsMovable;
+		// Read when the shootable is registered and whenever it notifies a change, already clamped between 0 and 10
+		float AutoAimPriority;
+#if !UE_BUILD_SHIPPING
+		// Whether the priority has been reported to differ from the one of the shootable since it last notified a change
+		bool bHasReportedPriorityDrift;
+#endif
+	};
+	TSparseArray<FShootableEntry> Entries;
+	TMap<const AActor*, int32> EntryIndicesByActor;
+	TMap<FIntVector, TArray<int32>> EntryIndicesByCell;
+	FDelegateHandle ActorSpawnedHandle;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "AmmoWidget.generated.h"
+
+class UProjectileShooterComponent;
+class UTextBlock;
+class UProgressBar;
+
+/** Shows the ammo and the reload cooldown of a projectile shooter without polling it.
+	The ammo text is only updated when the shooter notifies that the ammo has changed, and the cooldown bar is animated
+	locally from the time at which the reload started, so nothing is asked to the shooter while nothing changes */
+UCLASS(Abstract)
+class BERLINBYTEST_API UAmmoWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+//FUNCTIONS
+public:
+	// Sets default values for this widget's properties
+	UAmmoWidget(const FObjectInitializer& ObjectInitializer);
+	/** Selects the shooter whose ammo is shown. If none is selected when the widget is constructed,
+		the shooter of the pawn of the owning player is used */
+	UFUNCTION(BlueprintCallable, Category = "Ammo Widget")
+		void SetShooter(UProjectileShooterComponent* InShooter);
+
+protected:
+	// Called when the widget is added to the screen
+	virtual void NativeConstruct() override;
+	// Called when the widget is removed from the screen
+	virtual void NativeDestruct() override;
+	// Called every frame, although it only does any work while a reload cooldown is running
+	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+	// Called whenever the ammo shown changes, so that Blueprints can add their own feedback
+	UFUNCTION(BlueprintImplementableEvent, Category = "Ammo Widget")
+		void OnAmmoUpdated(int32 InCurrentAmmo, int32 InMaximumAmmo);
+	// Called whenever the reload cooldown progress shown changes, from 0 when it starts to 1 when it ends
+	UFUNCTION(BlueprintImplementableEvent, Category = "Ammo Widget")
+		void OnReloadProgressUpdated(float InReloadProgress);
+
+private:
+	// Binds the widget to the events of the shooter and shows its current state
+	void BindToShooter();
+	// Unbinds the widget from the events of the shooter
+	void UnbindFromShooter();
+	// Shows the current state of the shooter
+	void RefreshFromShooter();
+	void HandleAmmoChanged(int32 InCurrentAmmo, int32 InMaximumAmmo);
+	void HandleReloadStarted(float InStartTimeInSeconds, float InDurationInSeconds);
+	void HandleReloadCompleted();
+	// Shows the progress of the reload cooldown
+	void SetReloadProgress(float InReloadProgress);
+
+//VARIABLES
+public:
+	// Text in which the ammo is shown, if the widget has one with this name
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Widget", meta = (BindWidgetOptional))
+		UTextBlock* AmmoText;
+	// Bar in which the reload cooldown progress is shown, if the widget has one with this name
+	UPROPERTY(BlueprintReadOnly, Category = "Ammo Widget", meta = (BindWidgetOptional))
+		UProgressBar* ReloadProgressBar;
+	// Format of the ammo text, where {CurrentAmmo} and {MaximumAmmo} are replaced by their values
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ammo Widget")
+		FText AmmoTextFormat;
+
+private:
+	TWeakObjectPtr<UProjectileShooterComponent> Shooter;
+	FDelegateHandle AmmoChangedHandle;
+	FDelegateHandle ReloadStartedHandle;
+	FDelegateHandle ReloadCompletedHandle;
+	// State of the reload cooldown being animated
+	bool bIsReloading;
+	float ReloadStartTimeInSeconds;
+	float ReloadDurationInSeconds;
+};